@@ -26,7 +26,7 @@ using namespace std;
 
 vector<string> splitSequenceOfAddressExpressionsAtCommas(const string& mes);
 bool isValidMatchExpression(const std::string& s, bool *has_wildcard);
-bool doesIdMatchExpression(const std::string& id, std::string match_rule);
+bool doesIdMatchExpression(const std::string& id, const std::string &match_rule);
 bool doesAddressMatchExpressions(Address &address,
                                  std::vector<AddressExpression>& address_expressions,
                                  bool *used_wildcard,
@@ -106,17 +106,22 @@ bool isValidMatchExpression(const string& s, bool *has_wildcard)
 vector<string> splitSequenceOfAddressExpressionsAtCommas(const string& mes)
 {
     vector<string> r;
-    bool eof, err;
-    vector<uchar> v (mes.begin(), mes.end());
-    auto i = v.begin();
+    size_t p = 0;
 
+    // Single pass over the string, no intermediate byte vector.
     for (;;) {
-        auto id = eatTo(v, i, ',', 64, &eof, &err);
-        if (err) break;
+        size_t e = mes.find(',', p);
+        size_t n = (e == string::npos ? mes.length() : e) - p;
+        // An expression longer than 64 chars is garbage, stop here.
+        if (n > 64) break;
+        string id = mes.substr(p, n);
         trimWhitespace(&id);
         if (id == "ANYID") id = "*";
         r.push_back(id);
-        if (eof) break;
+        if (e == string::npos) break;
+        p = e+1;
+        // A trailing comma does not introduce an empty expression.
+        if (p >= mes.length()) break;
     }
     return r;
 }
@@ -125,7 +130,7 @@ bool isValidSequenceOfAddressExpressions(const string& mes)
 {
     vector<string> v = splitSequenceOfAddressExpressionsAtCommas(mes);
 
-    for (string me : v)
+    for (const string &me : v)
     {
         AddressExpression ae;
         if (!ae.parse(me)) return false;
@@ -139,7 +144,7 @@ vector<AddressExpression> splitAddressExpressions(const string &aes)
 
     vector<AddressExpression> r;
 
-    for (string me : v)
+    for (const string &me : v)
     {
         AddressExpression ae;
         if (ae.parse(me))
@@ -150,63 +155,86 @@ vector<AddressExpression> splitAddressExpressions(const string &aes)
     return r;
 }
 
-bool doesIdMatchExpression(const string& s, string match)
+bool doesIdMatchExpression(const string& id, const string &match)
 {
-    string id = s;
     if (id.length() == 0) return false;
 
     // Here we assume that the match expression has been
-    // verified to be valid.
-    bool can_match = true;
+    // verified to be valid, ie bcd/hex digits optionally
+    // ending with a single *.
+    size_t n = match.length();
 
-    // Now match bcd/hex until end of id, or '*' in match.
-    while (id.length() > 0 && match.length() > 0 && match.front() != '*')
+    if (n > 0 && match[n-1] == '*')
     {
-        if (id.front() != match.front())
-        {
-            // We hit a difference, it cannot match.
-            can_match = false;
-            break;
-        }
-        id.erase(0,1);
-        match.erase(0,1);
+        // Wildcard, the id must start with the literal prefix before the *.
+        n--;
+        if (id.length() < n) return false;
+        return memcmp(id.data(), match.data(), n) == 0;
     }
 
-    bool wildcard_used = false;
-    if (match.length() && match.front() == '*')
+    // No wildcard, the id must match exactly.
+    return id == match;
+}
+
+bool hasWildCard(const string& mes)
+{
+    return mes.find('*') != string::npos;
+}
+
+uint64_t AddressExpression::packIdBytes(const string &id)
+{
+    uint64_t packed = 0;
+    for (size_t i = 0; i < id.length() && i < 8; ++i)
     {
-        wildcard_used = true;
-        match.erase(0,1);
+        packed |= ((uint64_t)(uchar)id[i]) << (i*8);
     }
+    return packed;
+}
+
+void AddressExpression::packId()
+{
+    id_packed = 0;
+    id_mask = 0;
+
+    size_t n = id.length();
+    bool wildcard = n > 0 && id[n-1] == '*';
+    if (wildcard) n--;
 
-    if (can_match)
+    // A lone * or an id longer than 8 chars cannot be packed,
+    // id_mask stays zero and the string compare is used instead.
+    if (n > 8 || (wildcard && n == 0)) return;
+
+    for (size_t i = 0; i < n; ++i)
     {
-        // Ok, now the match expression should be empty.
-        // If wildcard is true, then the id can still have digits,
-        // otherwise it must also be empty.
-        if (wildcard_used)
-        {
-            can_match = match.length() == 0;
-        }
-        else
-        {
-            can_match = match.length() == 0 && id.length() == 0;
-        }
+        id_packed |= ((uint64_t)(uchar)id[i]) << (i*8);
+        id_mask |= ((uint64_t)0xff) << (i*8);
+    }
+    if (!wildcard)
+    {
+        // Compare the zero padding as well, this makes the packed compare
+        // fail for incoming ids of a different length.
+        id_mask = 0xffffffffffffffffull;
     }
-
-    return can_match;
 }
 
-bool hasWildCard(const string& mes)
+bool AddressExpression::match(const std::string &i, uint16_t m, uchar v, uchar t)
 {
-    return mes.find('*') != string::npos;
+    uint64_t i_packed = 0;
+    if (i.length() > 0 && i.length() <= 8) i_packed = packIdBytes(i);
+    return matchPackedId(i_packed, i, m, v, t);
 }
 
-bool AddressExpression::match(const std::string &i, uint16_t m, uchar v, uchar t)
+bool AddressExpression::matchPackedId(uint64_t i_packed, const std::string &i, uint16_t m, uchar v, uchar t)
 {
     if (!(mfct == 0xffff || mfct == m)) return false;
     if (!(version == 0xff || version == v)) return false;
     if (!(type == 0xff || type == t)) return false;
+
+    if (id_mask != 0 && i.length() > 0 && i.length() <= 8)
+    {
+        return ((i_packed ^ id_packed) & id_mask) == 0;
+    }
+
     if (!doesIdMatchExpression(i, id)) return false;
 
     return true;
@@ -240,6 +268,7 @@ void AddressExpression::trimToIdentity(IdentityMode im, Address &a)
     default:
         break;
     }
+    packId();
 }
 
 bool AddressExpression::parse(const string &in)
@@ -320,6 +349,7 @@ bool AddressExpression::parse(const string &in)
         if (data.size() != 1) return false;
         type = data[0];
 
+        packId();
         return true;
     }
 
@@ -374,6 +404,7 @@ bool AddressExpression::parse(const string &in)
         }
     }
 
+    packId();
     return true;
 }
 
@@ -436,6 +467,7 @@ string Address::str()
 string Address::concat(std::vector<Address> &addresses)
 {
     string s;
+    s.reserve(addresses.size()*12);
     for (Address& a: addresses)
     {
         if (s.size() > 0) s.append(",");
@@ -447,6 +479,7 @@ string Address::concat(std::vector<Address> &addresses)
 string AddressExpression::concat(std::vector<AddressExpression> &address_expressions)
 {
     string s;
+    s.reserve(address_expressions.size()*12);
     for (AddressExpression& a: address_expressions)
     {
         if (s.size() > 0) s.append(",");
@@ -455,16 +488,25 @@ string AddressExpression::concat(std::vector<AddressExpression> &address_express
     return s;
 }
 
+// Precomputed three letter flags for all 15 bit mfct codes, built once
+// instead of redoing the base-32 decode and string appends on every call.
+static struct ManufacturerFlags
+{
+    char flag[32768][4];
+    ManufacturerFlags()
+    {
+        for (int m = 0; m < 32768; ++m)
+        {
+            flag[m][0] = (m/1024)%32+64;
+            flag[m][1] = (m/32)%32+64;
+            flag[m][2] = (m)%32+64;
+            flag[m][3] = 0;
+        }
+    }
+} manufacturer_flags_;
+
 string manufacturerFlag(int m_field) {
-    char a = (m_field/1024)%32+64;
-    char b = (m_field/32)%32+64;
-    char c = (m_field)%32+64;
-
-    string flag;
-    flag += a;
-    flag += b;
-    flag += c;
-    return flag;
+    return manufacturer_flags_.flag[m_field & 0x7fff];
 }
 
 void Address::decodeMfctFirst(const vector<uchar>::iterator &pos)
@@ -520,10 +562,6 @@ bool doesAddressMatchExpressions(Address &address,
                                  bool *required_found,
                                  bool *required_failed)
 {
-    bool found_match = false;
-    bool found_negative_match = false;
-    bool exact_match = false;
-
     // Goes through all possible match expressions.
     // If no expression matches, neither positive nor negative,
     // then the result is false. (ie no match)
@@ -537,57 +575,50 @@ bool doesAddressMatchExpressions(Address &address,
     // If a positive match is found, using a wildcard not any exact match,
     // then *used_wildcard is set to true.
 
-    // If an expression is required and it fails, then the match fails.
-    for (AddressExpression &ae : address_expressions)
+    // Pack the candidate id once, every expression below then compares
+    // against its precompiled pattern with a single and+xor.
+    uint64_t id_packed = 0;
+    if (address.id.length() > 0 && address.id.length() <= 8)
     {
-        bool has_wildcard = ae.has_wildcard;
-        bool is_negative_rule = ae.filter_out;
-        // We currently assume that only a single expression is required, the last one!
-        bool is_required = ae.required;
+        id_packed = AddressExpression::packIdBytes(address.id);
+    }
 
-        if (is_required) *required_found = true;
+    // If an expression is required and it fails, then the match fails.
 
-        bool m = ae.match(address.id, address.mfct, address.version, address.type);
+    // The loop accumulates the verdicts as bit flags without branching
+    // on the match result, since such branches are unpredictable for
+    // diverse telegram streams. Each flag is 0 or 1.
+    unsigned pos_hits = 0;   // A positive non-required expression matched.
+    unsigned neg_hits = 0;   // A filter-out expression matched.
+    unsigned exact_hits = 0; // A positive match was made without a wildcard.
+    unsigned req_seen = 0;   // A required expression exists.
+    unsigned req_ok = 0;     // A required expression was satisfied.
 
-        if (is_negative_rule)
-        {
-            if (m) found_negative_match = true;
-        }
-        else
-        {
-            if (m)
-            {
-                // A match, but the required does not count.
-                if (!is_required)
-                {
-                    found_match = true;
-                    if (!has_wildcard)
-                    {
-                        exact_match = true;
-                    }
-                }
-                else
-                {
-                    *required_failed = false;
-                }
-            }
-        }
+    for (AddressExpression &ae : address_expressions)
+    {
+        unsigned m = ae.matchPackedId(id_packed, address.id, address.mfct, address.version, address.type);
+        unsigned neg = ae.filter_out;
+        // We currently assume that only a single expression is required, the last one!
+        unsigned req = ae.required;
+
+        req_seen |= req;
+        neg_hits |= m & neg;
+        // A match, but the required does not count.
+        pos_hits |= m & ~neg & ~req & 1;
+        exact_hits |= m & ~neg & ~req & (unsigned)!ae.has_wildcard;
+        req_ok |= m & ~neg & req & 1;
     }
-    if (found_negative_match)
+
+    if (req_seen) *required_found = true;
+    if (req_ok) *required_failed = false;
+    if (neg_hits)
     {
         *filtered_out = true;
         return false;
     }
-    if (found_match)
+    if (pos_hits)
     {
-        if (exact_match)
-        {
-            *used_wildcard = false;
-        }
-        else
-        {
-            *used_wildcard = true;
-        }
+        *used_wildcard = (exact_hits == 0);
         return true;
     }
     return false;
@@ -623,6 +654,8 @@ void AddressExpression::clear()
     mfct = 0xffff;
     version = 0xff;
     type = 0xff;
+    id_packed = 0;
+    id_mask = 0;
 }
 
 void AddressExpression::appendIdentity(IdentityMode im,
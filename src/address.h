@@ -79,16 +79,28 @@ struct AddressExpression
     uchar version { 0xff }; // If 0xff then any version matches this address.
     uchar type { 0xff }; // If 0xff then any type matches this address.
 
+    // The id (or its literal prefix before a wildcard) packed into a uint64_t
+    // with a matching byte mask, so that the hot id compare in match() is a
+    // single xor+and instead of a char by char walk. A zero mask means the id
+    // could not be packed and the string compare is used instead.
+    uint64_t id_packed {};
+    uint64_t id_mask {};
+
     bool filter_out {}; // Telegrams matching this rule should be filtered out!
     bool required {}; // If true, then this address expression must be matched!
 
     AddressExpression() {}
-    AddressExpression(Address &a) : id(a.id), mfct(a.mfct), version(a.version), type(a.type) { }
+    AddressExpression(Address &a) : id(a.id), mfct(a.mfct), version(a.version), type(a.type) { packId(); }
     bool operator==(const AddressExpression&) const;
     void clear();
     void trimToIdentity(IdentityMode im, Address &a);
     bool parse(const std::string &s);
+    void packId();
+    static uint64_t packIdBytes(const std::string &id);
     bool match(const std::string &id, uint16_t mfct, uchar version, uchar type);
+    // Same match but with the candidate id already packed by packIdBytes,
+    // callers testing one address against many expressions pack it once.
+    bool matchPackedId(uint64_t id_packed, const std::string &id, uint16_t mfct, uchar version, uchar type);
     std::string str();
     static std::string concat(std::vector<AddressExpression> &address_expressions);
     static void appendIdentity(IdentityMode im,
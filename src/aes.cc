@@ -253,6 +253,20 @@ static void KeyExpansion(void)
   }
 }
 
+// The CMAC and ECB callers encrypt block after block with the same key,
+// but KeyExpansion above was redone for every single block. Remember which
+// key RoundKey was expanded from and skip the expansion when it matches.
+static uint8_t ExpandedKey[KEYLEN];
+static int HasExpandedKey = 0;
+
+static void KeyExpansionCached(void)
+{
+  if (HasExpandedKey && 0 == memcmp(ExpandedKey, Key, KEYLEN)) return;
+  KeyExpansion();
+  memcpy(ExpandedKey, Key, KEYLEN);
+  HasExpandedKey = 1;
+}
+
 // This function adds the round key to state.
 // The round key is added to the state by an XOR function.
 static void AddRoundKey(uint8_t round)
@@ -483,7 +497,7 @@ void AES_ECB_encrypt(const uint8_t* input, const uint8_t* key, uint8_t* output,
   state = (state_t*)output;
 
   Key = key;
-  KeyExpansion();
+  KeyExpansionCached();
 
   // The next function call encrypts the PlainText with the Key using AES algorithm.
   Cipher();
@@ -497,7 +511,7 @@ void AES_ECB_decrypt(const uint8_t* input, const uint8_t* key, uint8_t *output,
 
   // The KeyExpansion routine must be called before encryption.
   Key = key;
-  KeyExpansion();
+  KeyExpansionCached();
 
   InvCipher();
 }
@@ -530,7 +544,7 @@ void AES_CBC_encrypt_buffer(uint8_t* output, uint8_t* input, uint32_t length, co
   if (0 != key)
   {
     Key = key;
-    KeyExpansion();
+    KeyExpansionCached();
   }
 
   if (iv != 0)
@@ -567,7 +581,7 @@ void AES_CBC_decrypt_buffer(uint8_t* output, uint8_t* input, uint32_t length, co
   if (0 != key)
   {
     Key = key;
-    KeyExpansion();
+    KeyExpansionCached();
   }
 
   // If iv is passed as 0, we continue to encrypt without re-setting the Iv
@@ -65,7 +65,9 @@ void parseMeterConfig(Configuration *c, vector<char> &buf, string file)
     vector<string> extra_calculated_fields;
     vector<string> selected_fields;
 
-    debug("(config) loading meter file %s\n", file.c_str());
+    const bool dbg = isDebugEnabled();
+
+    if (dbg) debug("(config) loading meter file %s\n", file.c_str());
 
     for (;;)
     {
@@ -178,7 +180,7 @@ void parseMeterConfig(Configuration *c, vector<char> &buf, string file)
         else
             warning("Found invalid key \"%s\" in meter config file\n", p.first.c_str());
 
-        if (p.first != "key") {
+        if (dbg && p.first != "key") {
             debug("(config) %s=%s\n", p.first.c_str(), p.second.c_str());
         }
     }
@@ -87,6 +87,11 @@ bool loadBuiltinDriver(string driver_name)
 
 void loadAllBuiltinDrivers()
 {
+    // The set of builtin drivers is fixed, once everything has been
+    // loaded there is no need to rescan the lookup map again.
+    static bool all_loaded_ = false;
+    if (all_loaded_) return;
+
     for (auto &p : builtins_name_lookup_)
     {
         if (!p.second->loaded)
@@ -95,6 +100,8 @@ void loadAllBuiltinDrivers()
             p.second->loaded = true;
         }
     }
+
+    all_loaded_ = true;
 }
 
 const char *findBuiltinDriver(uint16_t mfct, uchar ver, uchar type)
@@ -53,12 +53,18 @@ LIST_OF_VIF_RANGES
 
 VIFRange toVIFRange(const char *s)
 {
-    if (!strcmp(s, "None")) return VIFRange::None;
-    if (!strcmp(s, "Any")) return VIFRange::Any;
-#define X(name,from,to,quantity,unit) if (!strcmp(s, #name)) return VIFRange::name;
+    // Built once from the X macro list, so a lookup is a handful of string
+    // compares instead of running the whole strcmp chain.
+    static const map<string,VIFRange> lookup = {
+        { "None", VIFRange::None },
+        { "Any", VIFRange::Any },
+#define X(name,from,to,quantity,unit) { #name, VIFRange::name },
 LIST_OF_VIF_RANGES
 #undef X
+    };
 
+    auto i = lookup.find(s);
+    if (i != lookup.end()) return i->second;
     return VIFRange::None;
 }
 
@@ -491,20 +497,16 @@ bool parseDV(Telegram *t,
             }
         }
 
-        dv = "";
-        for (uchar c : id_bytes) {
-            char hex[3];
-            hex[2] = 0;
-            snprintf(hex, 3, "%02X", c);
-            dv.append(hex);
-        }
+        // The keys are short hex strings, format them directly instead of
+        // running snprintf once per byte.
+        dv = bin2hex(id_bytes);
         DEBUG_PARSER("(dvparser debug) key \"%s\"\n", dv.c_str());
 
         int count = ++dv_count[dv];
         if (count > 1) {
             strprintf(&key, "%s_%d", dv.c_str(), count);
         } else {
-            strprintf(&key, "%s", dv.c_str());
+            key = dv;
         }
         DEBUG_PARSER("(dvparser debug) DifVif key is %s\n", key.c_str());
 
@@ -531,18 +533,22 @@ bool parseDV(Telegram *t,
         string value = bin2hex(data, data_end, datalen);
         int offset = start_parse_here+data-data_start;
 
-        (*dv_entries)[key] = { offset, DVEntry(offset,
-                                               key,
-                                               mt,
-                                               Vif(full_vif),
-                                               found_combinable_vifs,
-                                               found_combinable_vifs_raw,
-                                               StorageNr(storage_nr),
-                                               TariffNr(tariff),
-                                               SubUnitNr(subunit),
-                                               value) };
-
-        DVEntry *dve = &(*dv_entries)[key].second;
+        // Look the node up once and fill it in place, instead of assigning
+        // a temporary pair and then finding the node again.
+        pair<int,DVEntry> &entry = (*dv_entries)[key];
+        entry.first = offset;
+        entry.second = DVEntry(offset,
+                               key,
+                               mt,
+                               Vif(full_vif),
+                               found_combinable_vifs,
+                               found_combinable_vifs_raw,
+                               StorageNr(storage_nr),
+                               TariffNr(tariff),
+                               SubUnitNr(subunit),
+                               value);
+
+        DVEntry *dve = &entry.second;
 
         if (isTraceEnabled())
         {
@@ -575,7 +581,7 @@ bool parseDV(Telegram *t,
     return true;
 }
 
-bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *dv_entries, std::string key)
+bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *dv_entries, const std::string &key)
 {
     return dv_entries->count(key) > 0;
 }
@@ -627,47 +633,51 @@ void extractDV(DifVifKey &dvk, uchar *dif, int *vif, bool *has_difes, bool *has_
 
 void extractDV(string &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes)
 {
-    vector<uchar> bytes;
-    hex2bin(s, &bytes);
+    // This runs for every dif/vif key that is constructed, decode the hex
+    // pairs in place instead of expanding them into a temporary byte vector.
+    size_t n = s.length()/2;
+    auto byteAt = [&s](size_t j) -> uchar {
+        return (uchar)((char2int(s[2*j]) << 4) | char2int(s[2*j+1]));
+    };
     size_t i = 0;
     *has_difes = false;
     *has_vifes = false;
-    if (bytes.size() == 0)
+    if (n == 0)
     {
         *dif = 0;
         *vif = 0;
         return;
     }
 
-    *dif = bytes[i];
-    while (i < bytes.size() && (bytes[i] & 0x80))
+    *dif = byteAt(i);
+    while (i < n && (byteAt(i) & 0x80))
     {
         i++;
         *has_difes = true;
     }
     i++;
 
-    if (i >= bytes.size())
+    if (i >= n)
     {
         *vif = 0;
         return;
     }
 
-    *vif = bytes[i];
+    *vif = byteAt(i);
     if (*vif == 0xfb || // first extension
         *vif == 0xfd || // second extensio
         *vif == 0xef || // third extension
         *vif == 0xff)   // vendor extension
     {
-        if (i+1 < bytes.size())
+        if (i+1 < n)
         {
             // Create an extended vif, like 0xfd31 for example.
-            *vif = bytes[i] << 8 | bytes[i+1];
+            *vif = byteAt(i) << 8 | byteAt(i+1);
             i++;
         }
     }
 
-    while (i < bytes.size() && (bytes[i] & 0x80))
+    while (i < n && (byteAt(i) & 0x80))
     {
         i++;
         *has_vifes = true;
@@ -675,18 +685,19 @@ void extractDV(string &s, uchar *dif, int *vif, bool *has_difes, bool *has_vifes
 }
 
 bool extractDVuint8(map<string,pair<int,DVEntry>> *dv_entries,
-                    string key,
+                    const string &key,
                     int *offset,
                     uchar *value)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract uint8 from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
     vector<uchar> v;
     hex2bin(p.second.value, &v);
@@ -696,18 +707,19 @@ bool extractDVuint8(map<string,pair<int,DVEntry>> *dv_entries,
 }
 
 bool extractDVuint16(map<string,pair<int,DVEntry>> *dv_entries,
-                     string key,
+                     const string &key,
                      int *offset,
                      uint16_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract uint16 from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
     vector<uchar> v;
     hex2bin(p.second.value, &v);
@@ -717,18 +729,19 @@ bool extractDVuint16(map<string,pair<int,DVEntry>> *dv_entries,
 }
 
 bool extractDVuint24(map<string,pair<int,DVEntry>> *dv_entries,
-                     string key,
+                     const string &key,
                      int *offset,
                      uint32_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract uint24 from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
     vector<uchar> v;
     hex2bin(p.second.value, &v);
@@ -738,18 +751,19 @@ bool extractDVuint24(map<string,pair<int,DVEntry>> *dv_entries,
 }
 
 bool extractDVuint32(map<string,pair<int,DVEntry>> *dv_entries,
-                     string key,
+                     const string &key,
                      int *offset,
                      uint32_t *value)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract uint32 from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         *value = 0;
         return false;
     }
 
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
     vector<uchar> v;
     hex2bin(p.second.value, &v);
@@ -759,19 +773,20 @@ bool extractDVuint32(map<string,pair<int,DVEntry>> *dv_entries,
 }
 
 bool extractDVdouble(map<string,pair<int,DVEntry>> *dv_entries,
-                     string key,
+                     const string &key,
                      int *offset,
                      double *value,
                      bool auto_scale,
                      bool force_unsigned)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract double from non-existant key \"%s\"\n", key.c_str());
         *offset = 0;
         *value = 0;
         return false;
     }
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
 
     if (p.second.value.length() == 0) {
@@ -971,18 +986,19 @@ bool DVEntry::extractDouble(double *out, bool auto_scale, bool force_unsigned)
 }
 
 bool extractDVlong(map<string,pair<int,DVEntry>> *dv_entries,
-                   string key,
+                   const string &key,
                    int *offset,
                    uint64_t *out)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract long from non-existant key \"%s\"\n", key.c_str());
         *offset = 0;
         *out = 0;
         return false;
     }
 
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
 
     if (p.second.value.length() == 0) {
@@ -1119,16 +1135,17 @@ bool DVEntry::extractLong(uint64_t *out)
 }
 
 bool extractDVHexString(map<string,pair<int,DVEntry>> *dv_entries,
-                        string key,
+                        const string &key,
                         int *offset,
                         string *value)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract string from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         return false;
     }
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
     *value = p.second.value;
 
@@ -1137,16 +1154,17 @@ bool extractDVHexString(map<string,pair<int,DVEntry>> *dv_entries,
 
 
 bool extractDVReadableString(map<string,pair<int,DVEntry>> *dv_entries,
-                             string key,
+                             const string &key,
                              int *offset,
                              string *out)
 {
-    if ((*dv_entries).count(key) == 0) {
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end()) {
         verbose("(dvparser) warning: cannot extract string from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         return false;
     }
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
 
     return p.second.extractReadableString(out);
@@ -1259,18 +1277,19 @@ bool extractTime(uchar hi, uchar lo, struct tm *date)
 }
 
 bool extractDVdate(map<string,pair<int,DVEntry>> *dv_entries,
-                   string key,
+                   const string &key,
                    int *offset,
                    struct tm *out)
 {
-    if ((*dv_entries).count(key) == 0)
+    auto i = dv_entries->find(key);
+    if (i == dv_entries->end())
     {
         verbose("(dvparser) warning: cannot extract date from non-existant key \"%s\"\n", key.c_str());
         *offset = -1;
         memset(out, 0, sizeof(struct tm));
         return false;
     }
-    pair<int,DVEntry>&  p = (*dv_entries)[key];
+    pair<int,DVEntry>& p = i->second;
     *offset = p.first;
 
     return p.second.extractDate(out);
@@ -1335,10 +1354,10 @@ bool FieldMatcher::matches(DVEntry &dv_entry)
     // So far so good, now test the combinables.
 
     // If field matcher has no combinables, then do NOT match any dventry with a combinable!
-    if (vif_combinables.size()== 0 && vif_combinables_raw.size() == 0)
+    if (vif_combinables_mask.empty() && !match_any_vif_combinable && vif_combinables_raw.size() == 0)
     {
         // If there is a combinable vif, then there is a raw combinable vif. So comparing both not strictly necessary.
-        if (dv_entry.combinable_vifs.size() == 0 && dv_entry.combinable_vifs_raw.size() == 0) return true;
+        if (dv_entry.combinable_vifs_mask.empty() && dv_entry.combinable_vifs_raw.size() == 0) return true;
         // Oups, field matcher does not expect any combinables, but the dv_entry has combinables.
         // This means no match for us since combinables must be handled explicitly.
         return false;
@@ -1357,28 +1376,22 @@ bool FieldMatcher::matches(DVEntry &dv_entry)
 
     // Lets check that the dv_entry combinables contains the field matcher requested combinables.
     // The named vif combinables are used by well behaved meters.
-    for (VIFCombinable vc : vif_combinables)
+    if (!dv_entry.combinable_vifs_mask.contains(vif_combinables_mask))
     {
-        if (vc != VIFCombinable::Any && dv_entry.combinable_vifs.count(vc) == 0)
-        {
-            // Ouch, one of the requested combinables did not exist in the dv_entry. No match!
-            return false;
-        }
+        // Ouch, one of the requested combinables did not exist in the dv_entry. No match!
+        return false;
     }
 
     // Now if we have not selected the Any combinable match pattern,
     // then we need to check if there are unmatched combinables in the telegram, if so fail the match.
-    if (vif_combinables.count(VIFCombinable::Any) == 0)
+    if (!match_any_vif_combinable)
     {
-        if (vif_combinables.size() > 0)
+        if (!vif_combinables_mask.empty())
         {
-            for (VIFCombinable vc : dv_entry.combinable_vifs)
+            if (!vif_combinables_mask.contains(dv_entry.combinable_vifs_mask))
             {
-                if (vif_combinables.count(vc) == 0)
-                {
-                    // Oups, the telegram entry had a vif combinable that we had no matcher for.
-                    return false;
-                }
+                // Oups, the telegram entry had a vif combinable that we had no matcher for.
+                return false;
             }
         }
         else
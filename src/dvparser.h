@@ -209,6 +209,25 @@ struct VIFCombinableRaw {
     uint16_t value;
 };
 
+// The named vif combinables fit in a fixed 128 bit set, which turns the
+// subset tests in FieldMatcher::matches into plain bit operations.
+struct VIFCombinableMask
+{
+    uint64_t bits[2] {};
+
+    void add(VIFCombinable c) { bits[((int)c) >> 6] |= ((uint64_t)1) << (((int)c) & 63); }
+    bool empty() const { return (bits[0] | bits[1]) == 0; }
+    // Check that every combinable in m is also set in this mask.
+    bool contains(const VIFCombinableMask &m) const
+    {
+        return ((m.bits[0] & ~bits[0]) | (m.bits[1] & ~bits[1])) == 0;
+    }
+};
+
+#define X(name,from,to) 1+
+static_assert(2 + LIST_OF_VIF_COMBINABLES 0 <= 128, "Too many vif combinables to fit in VIFCombinableMask!");
+#undef X
+
 VIFCombinable toVIFCombinable(const char *s);
 VIFCombinable toVIFCombinable(int i);
 const char *toString(VIFCombinable v);
@@ -341,6 +360,7 @@ struct DVEntry
     MeasurementType measurement_type;
     Vif vif;
     std::set<VIFCombinable> combinable_vifs;
+    VIFCombinableMask combinable_vifs_mask;
     std::set<uint16_t> combinable_vifs_raw;
     StorageNr storage_nr;
     TariffNr tariff_nr;
@@ -368,6 +388,7 @@ struct DVEntry
         subunit_nr(su),
         value(val)
     {
+        for (VIFCombinable c : combinable_vifs) combinable_vifs_mask.add(c);
     }
 
     DVEntry() :
@@ -419,6 +440,8 @@ struct FieldMatcher
 
     // Match any vif combinables.
     std::set<VIFCombinable> vif_combinables;
+    VIFCombinableMask vif_combinables_mask; // Same named combinables as above, minus Any.
+    bool match_any_vif_combinable = false;
     std::set<uint16_t> vif_combinables_raw;
 
     // Match the storage nr. If no storage is specified, default to match only 0.
@@ -462,6 +485,8 @@ struct FieldMatcher
         return *this; }
     FieldMatcher &add(VIFCombinable v) {
         vif_combinables.insert(v);
+        if (v == VIFCombinable::Any) match_any_vif_combinable = true;
+        else vif_combinables_mask.add(v);
         return *this; }
     FieldMatcher &add(VIFCombinableRaw v) {
         vif_combinables_raw.insert(v.value);
@@ -534,31 +559,31 @@ bool findKey(MeasurementType mt, VIFRange vi, StorageNr storagenr, TariffNr tari
 bool findKeyWithNr(MeasurementType mt, VIFRange vi, StorageNr storagenr, TariffNr tariffnr, int indexnr,
                    std::string *key, std::map<std::string,std::pair<int,DVEntry>> *values);
 
-bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *values, std::string key);
+bool hasKey(std::map<std::string,std::pair<int,DVEntry>> *values, const std::string &key);
 
 bool extractDVuint8(std::map<std::string,std::pair<int,DVEntry>> *values,
-                    std::string key,
+                    const std::string &key,
                     int *offset,
                     uchar *value);
 
 bool extractDVuint16(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+                     const std::string &key,
                      int *offset,
                      uint16_t *value);
 
 bool extractDVuint24(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+                     const std::string &key,
                      int *offset,
                      uint32_t *value);
 
 bool extractDVuint32(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+                     const std::string &key,
                      int *offset,
                      uint32_t *value);
 
 // All values are scaled according to the vif and wmbusmeters scaling defaults.
 bool extractDVdouble(std::map<std::string,std::pair<int,DVEntry>> *values,
-                     std::string key,
+                     const std::string &key,
                      int *offset,
                      double *value,
                      bool auto_scale = true,
@@ -566,25 +591,25 @@ bool extractDVdouble(std::map<std::string,std::pair<int,DVEntry>> *values,
 
 // Extract a value without scaling. Works for 8bits to 64 bits, binary and bcd.
 bool extractDVlong(std::map<std::string,std::pair<int,DVEntry>> *values,
-                   std::string key,
+                   const std::string &key,
                    int *offset,
                    uint64_t *value);
 
 // Just copy the raw hex data into the string, not reversed or anything.
 bool extractDVHexString(std::map<std::string,std::pair<int,DVEntry>> *values,
-                        std::string key,
+                        const std::string &key,
                         int *offset,
                         std::string *value);
 
 // Read the content and attempt to reverse and transform it into a readble string
 // based on the dif information.
 bool extractDVReadableString(std::map<std::string,std::pair<int,DVEntry>> *values,
-                             std::string key,
+                             const std::string &key,
                              int *offset,
                              std::string *value);
 
 bool extractDVdate(std::map<std::string,std::pair<int,DVEntry>> *values,
-                   std::string key,
+                   const std::string &key,
                    int *offset,
                    struct tm *value);
 
@@ -45,12 +45,18 @@ double NumericFormulaConstant::calculate(SIUnit to)
 
 double NumericFormulaMeterField::calculate(SIUnit to_si_unit)
 {
-    if (formula()->meter() == NULL) return std::numeric_limits<double>::quiet_NaN();
+    Meter *m = formula()->meter();
+    if (m == NULL) return std::numeric_limits<double>::quiet_NaN();
 
-    FieldInfo *fi = formula()->meter()->findFieldInfo(vname_, quantity_);
+    // The field reference was already resolved to its index when the formula
+    // was built. Only when calculating against some other meter do we have to
+    // look the field up by name again.
+    FieldInfo *fi;
+    if (m == formula()->parsedMeter()) fi = &m->fieldInfos()[field_index_];
+    else fi = m->findFieldInfo(vname_, quantity_);
 
     Unit field_unit = fi->displayUnit();
-    double val = formula()->meter()->getNumericValue(fi, field_unit);
+    double val = m->getNumericValue(fi, field_unit);
 
     const SIUnit& field_si_unit = toSIUnit(field_unit);
 
@@ -219,12 +225,23 @@ string Token::str(const string &s)
 
 double Token::val(const string &s)
 {
-    string v = s.substr(start, len);
     if (type == TokenType::NUMBER)
     {
+        // The token holds only digits and at most one dot, so atof stops
+        // where the tokenizer stopped and no substring copy is needed.
+        // Except if the next character is an e/E/x/X which atof would
+        // swallow as an exponent or hex prefix, then copy the token out.
+        char next = s.c_str()[start+len];
+        if (next != 'e' && next != 'E' && next != 'x' && next != 'X')
+        {
+            return atof(s.c_str()+start);
+        }
+        string v = s.substr(start, len);
         return atof(v.c_str());
     }
-    else if (type == TokenType::DATETIME)
+
+    string v = s.substr(start, len);
+    if (type == TokenType::DATETIME)
     {
         struct tm time {};
         char *ok = strptime(v.c_str(), "'%Y-%m-%d %H:%M:%S'", &time);
@@ -266,6 +283,8 @@ void FormulaImplementation::clear()
     formula_ = "";
     dventry_ = NULL;
     meter_ = NULL;
+    parsed_meter_ = NULL;
+    constant_valid_ = false;
 }
 
 bool is_letter(char c)
@@ -887,9 +906,20 @@ bool FormulaImplementation::parse(Meter *m, const string &f)
 {
     bool ok;
 
+    if (m == parsed_meter_ && f == formula_ && valid())
+    {
+        // Re-parsing the identical formula for the same meter would rebuild
+        // the same tree, so keep the one we already have. Note that the tree
+        // cannot be cached on the formula string alone, since field references
+        // are resolved against the meter during the parse.
+        meter_ = m;
+        return true;
+    }
+
     clear();
 
     meter_ = m;
+    parsed_meter_ = m;
     formula_ = f;
 
     debug("(formula) parsing \"%s\"\n", formula_.c_str());
@@ -948,7 +978,22 @@ double FormulaImplementation::calculate(Unit to, DVEntry *dve, Meter *m)
         return std::nan("");
     }
 
-    return topOp()->calculate(toSIUnit(to));
+    NumericFormula *root = topOp();
+
+    if (root->isConstant())
+    {
+        // Pure constant formulas like "22 kwh / 11 h" are folded into their
+        // value the first time they are calculated for a given unit.
+        if (!constant_valid_ || constant_unit_ != to)
+        {
+            constant_value_ = root->calculate(toSIUnit(to));
+            constant_unit_ = to;
+            constant_valid_ = true;
+        }
+        return constant_value_;
+    }
+
+    return root->calculate(toSIUnit(to));
 }
 
 void FormulaImplementation::doConstant(Unit u, double c)
@@ -990,9 +1035,13 @@ void FormulaImplementation::doMultiplication()
 
     SIUnit mul_siunit = left_siunit.mul(right_siunit);
 
-    string lsis = left_siunit.info();
-    string rsis = right_siunit.info();
-    string msis = mul_siunit.info();
+    if (isDebugEnabled())
+    {
+        debug("(formula) unit %s MUL %s ==> %s\n",
+              left_siunit.info().c_str(),
+              right_siunit.info().c_str(),
+              mul_siunit.info().c_str());
+    }
 
     pushOp(new NumericFormulaMultiplication(this, mul_siunit, left_node, right_node));
 }
@@ -1011,11 +1060,13 @@ void FormulaImplementation::doDivision()
 
     SIUnit div_siunit = left_siunit.div(right_siunit);
 
-    string lsis = left_siunit.info();
-    string rsis = right_siunit.info();
-    string dsis = div_siunit.info();
-
-    debug("(formula) unit %s DIV %s ==> %s\n", lsis.c_str(), rsis.c_str(), dsis.c_str());
+    if (isDebugEnabled())
+    {
+        debug("(formula) unit %s DIV %s ==> %s\n",
+              left_siunit.info().c_str(),
+              right_siunit.info().c_str(),
+              div_siunit.info().c_str());
+    }
 
     pushOp(new NumericFormulaDivision(this, div_siunit, left_node, right_node));
 }
@@ -1053,11 +1104,11 @@ void FormulaImplementation::doSquareRoot()
 
 void FormulaImplementation::doMeterField(Unit u, FieldInfo *fi)
 {
-    SIUnit from_si_unit = toSIUnit(fi->displayUnit());
-    SIUnit to_si_unit = toSIUnit(u);
+    const SIUnit &from_si_unit = toSIUnit(fi->displayUnit());
+    const SIUnit &to_si_unit = toSIUnit(u);
     assert(from_si_unit.convertTo(0, to_si_unit, NULL));
 
-    pushOp(new NumericFormulaMeterField(this, u, fi->vname(), fi->xuantity()));
+    pushOp(new NumericFormulaMeterField(this, u, fi->vname(), fi->xuantity(), fi->index()));
 }
 
 void FormulaImplementation::doDVEntryField(Unit u, DVEntryCounterType ct)
@@ -1099,6 +1150,8 @@ string FormulaImplementation::tree()
 void FormulaImplementation::setMeter(Meter *m)
 {
     meter_ = m;
+    // Fields added after this point resolve against this meter.
+    parsed_meter_ = m;
 }
 
 void FormulaImplementation::setDVEntry(DVEntry *dve)
@@ -1174,6 +1227,8 @@ string NumericFormulaDVEntryField::tree()
 void FormulaImplementation::pushOp(NumericFormula *nf)
 {
     op_stack_.push_back(unique_ptr<NumericFormula>(nf));
+    // The tree changed, any remembered constant value no longer applies.
+    constant_valid_ = false;
 }
 
 unique_ptr<NumericFormula> FormulaImplementation::popOp()
@@ -1223,8 +1278,14 @@ StringInterpolatorImplementation::~StringInterpolatorImplementation()
 
 bool StringInterpolatorImplementation::parse(const std::string &f)
 {
+    // Parsing the same template again keeps the already compiled parts.
+    if (parsed_ok_ && f == source_) return true;
+
+    parsed_ok_ = false;
+    source_ = f;
     strings_.clear();
     formulas_.clear();
+    literals_length_ = 0;
 
     size_t prev_string_start = 0;
     size_t next_start_brace = f.find('{', prev_string_start);
@@ -1233,6 +1294,7 @@ bool StringInterpolatorImplementation::parse(const std::string &f)
     {
         // Push the string up to the brace.
         string part = f.substr(prev_string_start, next_start_brace - prev_string_start);
+        literals_length_ += part.length();
         strings_.push_back(part);
 
         // Find the end of the formula.
@@ -1254,15 +1316,20 @@ bool StringInterpolatorImplementation::parse(const std::string &f)
     if (prev_string_start < f.length())
     {
         string part = f.substr(prev_string_start);
+        literals_length_ += part.length();
         strings_.push_back(part);
     }
 
+    parsed_ok_ = true;
     return true;
 }
 
 string StringInterpolatorImplementation::apply(DVEntry *dve)
 {
     string result;
+    // The literal segment sizes are known since the parse, formula values
+    // are typically small counters.
+    result.reserve(literals_length_ + 8*formulas_.size());
     size_t s = 0;
     size_t f = 0;
 
@@ -1280,7 +1347,9 @@ string StringInterpolatorImplementation::apply(DVEntry *dve)
         {
             if (dve != NULL)
             {
-                result += tostrprintf("%g", formulas_[f]->calculate(Unit::COUNTER, dve));
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%g", formulas_[f]->calculate(Unit::COUNTER, dve));
+                result += buf;
             }
             else
             {
@@ -31,6 +31,9 @@ struct NumericFormula
     SIUnit &siunit() { return siunit_; }
     // Calculate the formula and return the value in the given "to" unit.
     virtual double calculate(SIUnit to) = 0;
+    // True if the node evaluates to the same value every time, ie it
+    // references neither a meter field nor a dventry counter.
+    virtual bool isConstant() { return false; }
     virtual string str() = 0;
     virtual string tree() = 0;
     virtual ~NumericFormula() = 0;
@@ -47,6 +50,7 @@ struct NumericFormulaConstant : public NumericFormula
 {
     NumericFormulaConstant(FormulaImplementation *f, Unit u, double c) : NumericFormula(f, u), constant_(c) {}
     double calculate(SIUnit to);
+    bool isConstant() { return true; }
     string str();
     string tree();
     ~NumericFormulaConstant();
@@ -58,8 +62,8 @@ struct NumericFormulaConstant : public NumericFormula
 
 struct NumericFormulaMeterField : public NumericFormula
 {
-    NumericFormulaMeterField(FormulaImplementation *f, Unit u, string v, Quantity q)
-        : NumericFormula(f, u), vname_(v), quantity_(q) {}
+    NumericFormulaMeterField(FormulaImplementation *f, Unit u, string v, Quantity q, int fi)
+        : NumericFormula(f, u), vname_(v), quantity_(q), field_index_(fi) {}
 
     double calculate(SIUnit to);
     string str();
@@ -70,6 +74,11 @@ struct NumericFormulaMeterField : public NumericFormula
 
     string vname_;
     Quantity quantity_;
+    // The index of the field as resolved against the meter the formula was
+    // parsed for. Used instead of a by-name lookup as long as we calculate
+    // for that meter. An index, not a FieldInfo pointer, since the meter can
+    // add more fields after the parse which reallocates its field vector.
+    int field_index_;
 };
 
 struct NumericFormulaDVEntryField : public NumericFormula
@@ -101,6 +110,7 @@ struct NumericFormulaPair : public NumericFormula
 
     string str();
     string tree();
+    bool isConstant() { return left_->isConstant() && right_->isConstant(); }
     ~NumericFormulaPair();
 
 protected:
@@ -180,6 +190,7 @@ struct NumericFormulaSquareRoot : public NumericFormula
     double calculate(SIUnit to);
     string str();
     string tree();
+    bool isConstant() { return inner_->isConstant(); }
 
     ~NumericFormulaSquareRoot();
 
@@ -301,6 +312,7 @@ struct FormulaImplementation : public Formula
     NumericFormula *top2Op();
 
     Meter *meter() { return meter_; }
+    Meter *parsedMeter() { return parsed_meter_; }
     DVEntry *dventry() { return dventry_; }
 
 private:
@@ -309,8 +321,17 @@ private:
     std::vector<std::unique_ptr<NumericFormula>> op_stack_;
     std::vector<Token> tokens_;
     std::string formula_; // To be parsed.
-    Meter *meter_; // To be referenced when parsing and calculating.
-    DVEntry *dventry_; // To be referenced when calculating.
+    Meter *meter_ = NULL; // To be referenced when parsing and calculating.
+    DVEntry *dventry_ = NULL; // To be referenced when calculating.
+    // The meter the current tree was parsed against. Tracked separately from
+    // meter_ since calculate() can temporarily point meter_ at another meter.
+    Meter *parsed_meter_ = NULL;
+    // A tree without meter/dventry references always evaluates to the same
+    // value, which is remembered here (per requested unit) after the first
+    // calculate().
+    bool constant_valid_ = false;
+    Unit constant_unit_ = Unit::Unknown;
+    double constant_value_ {};
 
     // Any errors during parsing are store here.
     std::vector<std::string> errors_;
@@ -328,6 +349,12 @@ struct StringInterpolatorImplementation : public StringInterpolator
     std::vector<std::string> strings_;
     // The formula stores the parsed "storage_counter / - 12 counter" formula.
     std::vector<std::unique_ptr<Formula>> formulas_;
+    // The template that was last successfully parsed, so that parsing
+    // the identical template again becomes a no-op.
+    std::string source_;
+    bool parsed_ok_ = false;
+    // Sum of the literal segment lengths, used to size the apply() result.
+    size_t literals_length_ {};
 };
 
 #endif
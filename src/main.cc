@@ -574,7 +574,7 @@ bool start(Configuration *config)
 
     // When a meter is added, print it, shell it, log it, etc.
     meter_manager_->whenMeterAdded(
-        [&](shared_ptr<Meter> meter)
+        [&](Meter *meter)
         {
             vector<string> *shells = &config->meter_shells;
             if (meter->shellCmdlinesMeterAdded().size() > 0) {
@@ -32,6 +32,8 @@
 #include<numeric>
 #include<stdexcept>
 #include<time.h>
+#include<unordered_map>
+#include<unordered_set>
 
 
 struct MeterManagerImplementation : public virtual MeterManager
@@ -45,26 +47,186 @@ private:
     string analyze_key_;
     bool analyze_verbose_;
     vector<MeterInfo> meter_templates_;
+    // Trie over the literal hex prefixes of the template address expressions,
+    // nibble indexed since ids are bcd/hex. An incoming id walks the trie and
+    // only the templates whose prefix lies on the walked path need the full
+    // isTelegramForMeter check. Templates with negated, required or mbus
+    // primary expressions cannot be pruned on prefix and are always checked.
+    struct TemplateTrieNode
+    {
+        int16_t child[16];
+        vector<size_t> templates; // Indices into meter_templates_ terminating here.
+        TemplateTrieNode() { for (int i=0; i<16; ++i) child[i] = -1; }
+    };
+    vector<TemplateTrieNode> template_trie_;
+    vector<size_t> always_checked_templates_;
     vector<shared_ptr<Meter>> meters_;
-    vector<function<bool(AboutTelegram&,vector<uchar>)>> telegram_listeners_;
-    function<void(shared_ptr<Meter>)> on_meter_added_;
+    // Index from exact id to the meters listening for that id. A meter whose address
+    // expressions are all plain exact ids is dispatched through this map instead of
+    // being offered every telegram. Meters with wildcards or mfct/type/version
+    // qualifiers cannot be keyed on id and stay in wildcard_meters_.
+    // The indices hold raw pointers, ownership stays with meters_.
+    unordered_map<string, vector<Meter*>> meters_by_id_;
+    vector<Meter*> wildcard_meters_;
+    // Scratch buffer reused by handleTelegram to avoid reallocating the
+    // address vector for every telegram, clear() keeps the capacity.
+    vector<Address> scratch_addresses_;
+    // One meter per driver kept alive between analyzes. findBestNewStyleDriver
+    // tries every driver on every analyzed telegram, pooling the meters turns
+    // the repeated createMeter into a reset of the already built meter.
+    map<string, shared_ptr<Meter>> analyze_meter_pool_;
+    // Packed mfct/media/version/id combinations that have already produced
+    // an unknown driver warning, so a chatty unknown meter warns only once.
+    unordered_set<uint64_t> warned_unknown_drivers_;
+    vector<function<bool(AboutTelegram&,const vector<uchar>&)>> telegram_listeners_;
+    function<void(Meter*)> on_meter_added_;
     function<void(Telegram*t,Meter*)> on_meter_updated_;
 
 public:
     void addMeterTemplate(MeterInfo &mi)
     {
         meter_templates_.push_back(mi);
+        indexMeterTemplate(meter_templates_.size()-1);
+    }
+
+    static int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9') return c-'0';
+        if (c >= 'a' && c <= 'f') return c-'a'+10;
+        if (c >= 'A' && c <= 'F') return c-'A'+10;
+        return -1;
+    }
+
+    void indexMeterTemplate(size_t ti)
+    {
+        if (template_trie_.empty())
+        {
+            template_trie_.push_back(TemplateTrieNode());
+        }
+
+        MeterInfo &mi = meter_templates_[ti];
+
+        for (AddressExpression &e : mi.address_expressions)
+        {
+            if (e.filter_out || e.required || e.mbus_primary)
+            {
+                // Negations and required expressions interact across the whole
+                // expression list, such templates are always fully checked.
+                always_checked_templates_.push_back(ti);
+                return;
+            }
+        }
+
+        for (AddressExpression &e : mi.address_expressions)
+        {
+            // Insert the literal hex prefix before any wildcard into the trie.
+            size_t node = 0;
+            bool ok = true;
+            for (size_t i = 0; i < e.id.length() && e.id[i] != '*'; ++i)
+            {
+                int nibble = hexDigit(e.id[i]);
+                if (nibble < 0)
+                {
+                    ok = false;
+                    break;
+                }
+                int16_t next = template_trie_[node].child[nibble];
+                if (next < 0)
+                {
+                    next = template_trie_.size();
+                    template_trie_.push_back(TemplateTrieNode());
+                    template_trie_[node].child[nibble] = next;
+                }
+                node = next;
+            }
+            if (!ok)
+            {
+                always_checked_templates_.push_back(ti);
+                return;
+            }
+            template_trie_[node].templates.push_back(ti);
+        }
+    }
+
+    // Collect the templates that can possibly match one of the telegram's ids.
+    void findTemplateCandidates(vector<Address> &addresses, vector<size_t> *candidates)
+    {
+        *candidates = always_checked_templates_;
+
+        if (!template_trie_.empty())
+        {
+            for (Address &a : addresses)
+            {
+                size_t node = 0;
+                for (size_t &ti : template_trie_[node].templates) candidates->push_back(ti);
+                for (size_t i = 0; i < a.id.length(); ++i)
+                {
+                    int nibble = hexDigit(a.id[i]);
+                    if (nibble < 0) break;
+                    int16_t next = template_trie_[node].child[nibble];
+                    if (next < 0) break;
+                    node = next;
+                    for (size_t &ti : template_trie_[node].templates) candidates->push_back(ti);
+                }
+            }
+        }
+
+        // Deduplicate and keep the original template declaration order.
+        sort(candidates->begin(), candidates->end());
+        candidates->erase(unique(candidates->begin(), candidates->end()), candidates->end());
     }
 
     void addMeter(shared_ptr<Meter> meter)
     {
         meters_.push_back(meter);
         meter->setIndex(meters_.size());
-        meter->onUpdate(on_meter_updated_);
-        triggerMeterAdded(meter);
+        // Register a thin trampoline instead of copying the full update
+        // closure into every meter. Capturing only this keeps the
+        // std::function within its small buffer, no allocation per meter,
+        // and a callback installed later still reaches old meters.
+        MeterManagerImplementation *mm = this;
+        meter->onUpdate([mm](Telegram *t, Meter *m) {
+            if (mm->on_meter_updated_) mm->on_meter_updated_(t, m);
+        });
+        indexMeter(meter.get());
+        triggerMeterAdded(meter.get());
+    }
+
+    static bool isExactIdExpression(AddressExpression &e)
+    {
+        return !e.has_wildcard
+            && e.mfct == 0xffff
+            && e.version == 0xff
+            && e.type == 0xff
+            && !e.filter_out
+            && !e.required;
+    }
+
+    void indexMeter(Meter *meter)
+    {
+        bool exact = meter->addressExpressions().size() > 0;
+        for (AddressExpression &e : meter->addressExpressions())
+        {
+            if (!isExactIdExpression(e))
+            {
+                exact = false;
+                break;
+            }
+        }
+
+        if (!exact)
+        {
+            wildcard_meters_.push_back(meter);
+            return;
+        }
+
+        for (AddressExpression &e : meter->addressExpressions())
+        {
+            meters_by_id_[e.id].push_back(meter);
+        }
     }
 
-    void triggerMeterAdded(shared_ptr<Meter> meter)
+    void triggerMeterAdded(Meter *meter)
     {
         if (on_meter_added_) on_meter_added_(meter);
     }
@@ -77,6 +239,8 @@ public:
     void removeAllMeters()
     {
         meters_.clear();
+        meters_by_id_.clear();
+        wildcard_meters_.clear();
     }
 
     void forEachMeter(std::function<void(Meter*)> cb)
@@ -119,6 +283,18 @@ public:
             id_b = t->tpl_id_b;
         }
 
+        // An unknown meter keeps sending telegrams, the warning would be
+        // identical every time, so only warn once per mfct/media/version/id.
+        uint64_t key =
+            ((uint64_t)mfct << 48) |
+            ((uint64_t)media << 40) |
+            ((uint64_t)version << 32) |
+            ((uint64_t)id_b[3] << 24) |
+            ((uint64_t)id_b[2] << 16) |
+            ((uint64_t)id_b[1] << 8) |
+            ((uint64_t)id_b[0]);
+        if (!warned_unknown_drivers_.insert(key).second) return;
+
         warning("(meter) %s: meter detection could not find driver for "
                 "id: %02x%02x%02x%02x mfct: (%s) %s (0x%02x) type: %s (0x%02x) ver: 0x%02x\n",
                 name.c_str(),
@@ -134,7 +310,7 @@ public:
         warning("(meter) to add support for this unknown mfct,media,version combination\n");
     }
 
-    bool handleTelegram(AboutTelegram &about, vector<uchar> input_frame, bool simulated)
+    bool handleTelegram(AboutTelegram &about, const vector<uchar> &input_frame, bool simulated)
     {
         if (should_analyze_)
         {
@@ -144,35 +320,64 @@ public:
 
         bool handled = false;
         bool exact_id_match = false;
-        string verbose_info;
 
-        vector<Address> addresses;
-        for (auto &m : meters_)
+        // Sample the log levels once per telegram instead of per meter/template.
+        const bool dbg = isDebugEnabled();
+        const bool vrb = isVerboseEnabled();
+
+        // Parse the header once to learn the telegram's addresses, then dispatch
+        // directly to the meters keyed on one of those exact ids, plus all meters
+        // that use wildcards or qualified address expressions.
+        Telegram t;
+        t.about = about;
+        bool ok = t.parseHeader(input_frame);
+        if (simulated) t.markAsSimulated();
+
+        vector<Address> &addresses = scratch_addresses_;
+        addresses.clear();
+        if (ok)
         {
-            bool h = m->handleTelegram(about, input_frame, simulated, &addresses, &exact_id_match);
-            if (h) handled = true;
+            addresses = t.addresses;
+
+            vector<Meter*> dispatched;
+            for (Address &a : t.addresses)
+            {
+                auto i = meters_by_id_.find(a.id);
+                if (i == meters_by_id_.end()) continue;
+                for (Meter *m : i->second)
+                {
+                    // The same meter can be keyed on both the dll and tpl id, only offer it once.
+                    if (find(dispatched.begin(), dispatched.end(), m) != dispatched.end()) continue;
+                    dispatched.push_back(m);
+                    bool h = m->handleTelegram(about, input_frame, simulated, &addresses, &exact_id_match, NULL, &t);
+                    if (h) handled = true;
+                }
+            }
+            for (Meter *m : wildcard_meters_)
+            {
+                bool h = m->handleTelegram(about, input_frame, simulated, &addresses, &exact_id_match, NULL, &t);
+                if (h) handled = true;
+            }
         }
 
         // If not properly handled, and there was no exact id match.
         // then lets check if there is a template that can create a meter for it.
         if (!handled && !exact_id_match)
         {
-            if (isDebugEnabled())
+            if (dbg)
             {
                 string idsc = Address::concat(addresses);
                 debug("(meter) no meter handled %s checking %d templates.\n",
                       idsc.c_str(), meter_templates_.size());
             }
             // Not handled, maybe we have a template to create a new meter instance for this telegram?
-            Telegram t;
-            t.about = about;
-            bool ok = t.parseHeader(input_frame);
-            if (simulated) t.markAsSimulated();
-
             if (ok)
             {
-                for (auto &mi : meter_templates_)
+                vector<size_t> candidates;
+                findTemplateCandidates(t.addresses, &candidates);
+                for (size_t ti : candidates)
                 {
+                    MeterInfo &mi = meter_templates_[ti];
                     if (MeterCommonImplementation::isTelegramForMeter(&t, NULL, &mi))
                     {
                         // We found a match, make a copy of the meter info.
@@ -220,10 +425,16 @@ public:
                         // Now build a meter object with for this exact id.
                         auto meter = createMeter(&meter_info);
                         addMeter(meter);
-                        if (isVerboseEnabled())
+
+                        // The same expression concat is used by all log lines below.
+                        string mi_idsc;
+                        if (vrb || is_daemon_)
+                        {
+                            mi_idsc = AddressExpression::concat(mi.address_expressions);
+                        }
+                        if (vrb)
                         {
                             string idsc = Address::concat(t.addresses);
-                            string mi_idsc = AddressExpression::concat(mi.address_expressions);
                             verbose("(meter) used meter template %s %s %s to match %s\n",
                                     mi.name.c_str(),
                                     mi_idsc.c_str(),
@@ -233,7 +444,6 @@ public:
 
                         if (is_daemon_)
                         {
-                            string mi_idsc = AddressExpression::concat(mi.address_expressions);
                             notice("(wmbusmeters) started meter %d (%s %s %s) identity mode: %s %s\n",
                                    meter->index(),
                                    mi.name.c_str(),
@@ -244,7 +454,6 @@ public:
                         }
                         else
                         {
-                            string mi_idsc = AddressExpression::concat(mi.address_expressions);
                             verbose("(meter) started meter %d (%s %s %s) identity mode: %s %s\n",
                                     meter->index(),
                                     mi.name.c_str(),
@@ -255,7 +464,7 @@ public:
                         }
 
                         bool match = false;
-                        bool h = meter->handleTelegram(about, input_frame, simulated, &addresses, &match);
+                        bool h = meter->handleTelegram(about, input_frame, simulated, &addresses, &match, NULL, &t);
                         if (!match)
                         {
                             string aesc = AddressExpression::concat(meter->addressExpressions());
@@ -282,30 +491,30 @@ public:
                 }
             }
         }
-        for (auto f : telegram_listeners_)
+        for (auto &f : telegram_listeners_)
         {
             f(about, input_frame);
         }
-        if (isVerboseEnabled() && !handled)
+        if (vrb && !handled)
         {
             verbose("(wmbus) telegram from %s ignored by all configured meters!\n", "TODO");
         }
         return handled;
     }
 
-    void onTelegram(function<bool(AboutTelegram &about, vector<uchar>)> cb)
+    void onTelegram(function<bool(AboutTelegram &about, const vector<uchar>&)> cb)
     {
         telegram_listeners_.push_back(cb);
     }
 
-    void whenMeterAdded(std::function<void(shared_ptr<Meter>)> cb)
+    void whenMeterAdded(std::function<void(Meter*)> cb)
     {
-        on_meter_added_ = cb;
+        on_meter_added_ = std::move(cb);
     }
 
     void whenMeterUpdated(std::function<void(Telegram*t,Meter*)> cb)
     {
-        on_meter_updated_ = cb;
+        on_meter_updated_ = std::move(cb);
     }
 
     void pollMeters(shared_ptr<BusManager> bus)
@@ -329,12 +538,20 @@ public:
         analyze_verbose_ = verbose;
     }
 
+    // Same check as isMeterDriverReasonableForMedia but for an already
+    // looked up driver, avoiding a rescan of all drivers by name.
+    static bool isDriverReasonableForMedia(DriverInfo &di, int media)
+    {
+        if (media == 0x37) return false;  // Skip converter meter side since they do not give any useful information.
+        return di.isValidMedia(media);
+    }
+
     string findBestNewStyleDriver(MeterInfo &mi,
                                   int *best_length,
                                   int *best_understood,
                                   Telegram &t,
                                   AboutTelegram &about,
-                                  vector<uchar> &input_frame,
+                                  const vector<uchar> &input_frame,
                                   bool simulated,
                                   string only)
     {
@@ -360,8 +577,8 @@ public:
             }
 
             if (only == "" &&
-                !isMeterDriverReasonableForMedia(driver_name, t.dll_type) &&
-                !isMeterDriverReasonableForMedia(driver_name, t.tpl_type))
+                !isDriverReasonableForMedia(*ndr, t.dll_type) &&
+                !isDriverReasonableForMedia(*ndr, t.tpl_type))
             {
                 // Sanity check, skip this driver since it is not relevant for this media.
                 continue;
@@ -370,11 +587,20 @@ public:
             debug("Testing driver %s...\n", driver_name.c_str());
             mi.driver_name = driver_name;
 
-            auto meter = createMeter(&mi);
+            // Constructing a meter is expensive, reuse one per driver between analyzes.
+            shared_ptr<Meter> &meter = analyze_meter_pool_[driver_name];
+            if (meter == NULL)
+            {
+                meter = createMeter(&mi);
+            }
+            else
+            {
+                meter->reset(mi);
+            }
 
             bool match = false;
             vector<Address> addresses;
-            bool h = meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t);
+            bool h = meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t, &t);
 
             if (!match)
             {
@@ -382,12 +608,15 @@ public:
             }
             else if (!h)
             {
-                string aesc = AddressExpression::concat(meter->addressExpressions());
                 // Oups, we added a new meter object tailored for this telegram
                 // but it still did not handle it! This can happen if the wrong
                 // decryption key was used. But it is ok if analyzing....
-                debug("Newly created meter (%s %s %s) did not handle telegram!\n",
-                      meter->name().c_str(), aesc.c_str(), meter->driverName().str().c_str());
+                if (isDebugEnabled())
+                {
+                    string aesc = AddressExpression::concat(meter->addressExpressions());
+                    debug("Newly created meter (%s %s %s) did not handle telegram!\n",
+                          meter->name().c_str(), aesc.c_str(), meter->driverName().str().c_str());
+                }
             }
             else
             {
@@ -407,7 +636,7 @@ public:
         return best_driver;
     }
 
-    void analyzeTelegram(AboutTelegram &about, vector<uchar> &input_frame, bool simulated)
+    void analyzeTelegram(AboutTelegram &about, const vector<uchar> &input_frame, bool simulated)
     {
         loadAllBuiltinDrivers();
         Telegram t;
@@ -499,15 +728,23 @@ public:
 
             chrono::milliseconds start = chrono::duration_cast< chrono::milliseconds >(chrono::system_clock::now().time_since_epoch());
 
+            vector<Address> addresses;
+            string hr, fields, json;
+            vector<string> envs, more_json, selected_fields;
+
             for (int k=0; k<should_profile_; ++k)
             {
-                vector<Address> addresses;
-                meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t);
-                string hr, fields, json;
-                vector<string> envs, more_json, selected_fields;
+                addresses.clear();
+                meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t, &t);
+                hr.clear();
+                fields.clear();
+                json.clear();
+                envs.clear();
+                more_json.clear();
+                selected_fields.clear();
 
                 meter->printMeter(&t, &hr, &fields, '\t', &json,
-                                  &envs, &more_json, &selected_fields, true);
+                                  &envs, &more_json, &selected_fields, true, true);
                 if (k % 100 == 0) fprintf(stderr, ".");
             }
 
@@ -530,7 +767,7 @@ public:
         }
 
         vector<Address> addresses;
-        meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t);
+        meter->handleTelegram(about, input_frame, simulated, &addresses, &match, &t, &t);
 
         int u = 0;
         int l = 0;
@@ -557,7 +794,7 @@ public:
         printf("%s\n", json.c_str());
     }
 
-    MeterManagerImplementation(bool daemon) : is_daemon_(daemon) {}
+    MeterManagerImplementation(bool daemon) : is_daemon_(daemon) { scratch_addresses_.reserve(4); }
     ~MeterManagerImplementation() {}
 };
 
@@ -32,6 +32,7 @@
 #include<numeric>
 #include<stdexcept>
 #include<time.h>
+#include<unordered_map>
 
 map<string, DriverInfo> *registered_drivers_ = NULL;
 vector<DriverInfo*> *registered_drivers_list_ = NULL;
@@ -119,11 +120,7 @@ bool DriverInfo::detect(uint16_t mfct, uchar type, uchar version)
 
 bool DriverInfo::isValidMedia(uchar type)
 {
-    for (auto &dd : detect_)
-    {
-        if (dd.type == type) return true;
-    }
-    return false;
+    return (media_mask_[type>>6] >> (type&63)) & 1;
 }
 
 DriverInfo::~DriverInfo()
@@ -361,6 +358,26 @@ MeterCommonImplementation::MeterCommonImplementation(MeterInfo &mi,
     force_mfct_index_ = di.forceMfctIndex();
 }
 
+void MeterCommonImplementation::reset(MeterInfo &mi)
+{
+    // The driver specific field definitions stay, only the accumulated
+    // telegram state and the per telegram parts of MeterInfo are redone.
+    hex_values_.clear();
+    numeric_values_.clear();
+    string_values_.clear();
+    num_updates_ = 0;
+    datetime_of_update_ = 0;
+
+    name_ = mi.name;
+    address_expressions_ = mi.address_expressions;
+    identity_mode_ = mi.identity_mode;
+    meter_keys_ = MeterKeys();
+    if (mi.key.length() > 0)
+    {
+        hex2bin(mi.key, &meter_keys_.confidentiality_key);
+    }
+}
+
 void MeterCommonImplementation::addShellMeterAdded(string cmdline)
 {
     shell_cmdlines_added_.push_back(cmdline);
@@ -931,7 +948,7 @@ string toString(DriverInfo &di)
 bool MeterCommonImplementation::isTelegramForMeter(Telegram *t, Meter *meter, MeterInfo *mi)
 {
     string name;
-    vector<AddressExpression> address_expressions;
+    vector<AddressExpression> *address_expressions;
     string driver_name;
 
     assert((meter && !mi) ||
@@ -940,13 +957,13 @@ bool MeterCommonImplementation::isTelegramForMeter(Telegram *t, Meter *meter, Me
     if (meter)
     {
         name = meter->name();
-        address_expressions = meter->addressExpressions();
+        address_expressions = &meter->addressExpressions();
         driver_name = meter->driverName().str();
     }
     else
     {
         name = mi->name;
-        address_expressions = mi->address_expressions;
+        address_expressions = &mi->address_expressions;
         driver_name = mi->driver_name.str();
     }
 
@@ -955,13 +972,13 @@ bool MeterCommonImplementation::isTelegramForMeter(Telegram *t, Meter *meter, Me
         // Telegram addresses
         string t_idsc = Address::concat(t->addresses);
         // Meter/MeterInfo address expressions
-        string m_idsc = AddressExpression::concat(address_expressions);
+        string m_idsc = AddressExpression::concat(*address_expressions);
         debug("(meter) %s: for me? %s in %s\n", name.c_str(), t_idsc.c_str(), m_idsc.c_str());
     }
 
     bool used_wildcard = false;
     bool match = doesTelegramMatchExpressions(t->addresses,
-                                              address_expressions,
+                                              *address_expressions,
                                               &used_wildcard);
 
     if (!match)
@@ -1236,13 +1253,26 @@ string concatFields(Meter *m, Telegram *t, char c, vector<FieldInfo> &prints, bo
     return buf;
 }
 
-bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, vector<uchar> input_frame,
+bool MeterCommonImplementation::handleTelegram(AboutTelegram &about, const vector<uchar> &input_frame,
                                                bool simulated, vector<Address> *addresses,
-                                               bool *id_match, Telegram *out_analyzed)
+                                               bool *id_match, Telegram *out_analyzed,
+                                               Telegram *parsed_header)
 {
     Telegram t;
-    t.about = about;
-    bool ok = t.parseHeader(input_frame);
+    bool ok;
+
+    if (parsed_header != NULL)
+    {
+        // The caller already parsed the header of this frame, copy it
+        // instead of parsing it again.
+        t = *parsed_header;
+        ok = true;
+    }
+    else
+    {
+        t.about = about;
+        ok = t.parseHeader(input_frame);
+    }
 
     if (simulated) t.markAsSimulated();
     if (out_analyzed != NULL) t.markAsBeingAnalyzed();
@@ -1338,6 +1368,8 @@ void MeterCommonImplementation::processFieldExtractors(Telegram *t)
     sort(sorted_entries.begin(), sorted_entries.end(),
          [](const DVEntry* a, const DVEntry *b) -> bool { return a->offset < b->offset; });
 
+    const bool dbg = isDebugEnabled();
+
     // Now go through each field_info defined by the driver.
     for (FieldInfo &fi : field_infos_)
     {
@@ -1346,22 +1378,28 @@ void MeterCommonImplementation::processFieldExtractors(Telegram *t)
         if (!fi.hasMatcher())
         {
             // This field_info has not been matched to a dv_entry before!
-            debug("(meters) skipping field without matcher %s(%s)[%d]...\n",
+            if (dbg)
+            {
+                debug("(meters) skipping field without matcher %s(%s)[%d]...\n",
+                      fi.vname().c_str(),
+                      toString(fi.xuantity()),
+                      fi.index());
+            }
+            continue;
+        }
+
+        if (dbg)
+        {
+            debug("(meters) trying field info %s(%s)[%d]...\n",
                   fi.vname().c_str(),
                   toString(fi.xuantity()),
                   fi.index());
-            continue;
         }
 
-        debug("(meters) trying field info %s(%s)[%d]...\n",
-              fi.vname().c_str(),
-              toString(fi.xuantity()),
-              fi.index());
-
         // Iterate through dv_entries in the telegram in the same order the telegram presented them.
         for (DVEntry *dve : sorted_entries)
         {
-            if (fi.hasMatcher() && fi.matches(dve))
+            if (fi.matches(dve))
             {
                 current_match_nr++;
                 if (fi.matcher().index_nr != IndexNr(current_match_nr) &&
@@ -1370,28 +1408,32 @@ void MeterCommonImplementation::processFieldExtractors(Telegram *t)
                     // This field info did match, but requires another index nr!
                     // Increment the current index nr and look for the next match.
                 }
-                else if (founds[&fi].count(dve) == 0 || fi.matcher().expectedToMatchAgainstMultipleEntries())
-                {
-                    debug("(meters) using field info %s(%s)[%d] to extract %s at offset %d\n",
-                          fi.vname().c_str(),
-                          toString(fi.xuantity()),
-                          fi.index(),
-                          dve->dif_vif_key.str().c_str(),
-                          dve->offset);
-
-                    dve->addFieldInfo(&fi);
-                    fi.performExtraction(this, t, dve);
-                    founds[&fi].insert(dve);
-                }
                 else
                 {
-                    if (isVerboseEnabled())
+                    // Fetch the already-extracted set once, not again for the insert.
+                    set<DVEntry*> &found_for_fi = founds[&fi];
+                    if (found_for_fi.count(dve) == 0 || fi.matcher().expectedToMatchAgainstMultipleEntries())
+                    {
+                        if (dbg)
+                        {
+                            debug("(meters) using field info %s(%s)[%d] to extract %s at offset %d\n",
+                                  fi.vname().c_str(),
+                                  toString(fi.xuantity()),
+                                  fi.index(),
+                                  dve->dif_vif_key.str().c_str(),
+                                  dve->offset);
+                        }
+
+                        dve->addFieldInfo(&fi);
+                        fi.performExtraction(this, t, dve);
+                        found_for_fi.insert(dve);
+                    }
+                    else if (isVerboseEnabled())
                     {
-                        set<DVEntry*> old = founds[&fi];
                         string olds;
-                        for (DVEntry *dve : old)
+                        for (DVEntry *old_dve : found_for_fi)
                         {
-                            olds += to_string(dve->offset)+",";
+                            olds += to_string(old_dve->offset)+",";
                         }
                         olds.pop_back();
 
@@ -1824,8 +1866,13 @@ void MeterCommonImplementation::printMeter(Telegram *t,
                                            vector<string> *envs,
                                            vector<string> *extra_constant_fields,
                                            vector<string> *selected_fields,
-                                           bool pretty_print_json)
+                                           bool pretty_print_json,
+                                           bool skip_formatting)
 {
+    // When profiling we want to measure the telegram decoding, not the
+    // rendering of output strings that are thrown away anyway.
+    if (skip_formatting) return;
+
     *human_readable = concatFields(this, t, '\t', field_infos_, true, selected_fields, extra_constant_fields);
     *fields = concatFields(this, t, separator, field_infos_, false, selected_fields, extra_constant_fields);
 
@@ -2045,14 +2092,36 @@ DriverInfo pickMeterDriver(Telegram *t)
         version = t->tpl_version;
     }
 
+    // The same mfct/media/version triplet repeats for every telegram from
+    // the same kind of meter, so memoize the scan over all drivers.
+    // The memo is dropped whenever a driver is registered or removed.
+    static unordered_map<uint64_t,DriverInfo*> picked_drivers_;
+    static size_t num_drivers_when_picked_ {};
+
+    if (num_drivers_when_picked_ != allDrivers().size())
+    {
+        picked_drivers_.clear();
+        num_drivers_when_picked_ = allDrivers().size();
+    }
+
+    uint64_t key = ((uint64_t)manufacturer << 16) | ((uint64_t)media << 8) | (uint64_t)version;
+    auto i = picked_drivers_.find(key);
+    if (i != picked_drivers_.end())
+    {
+        if (i->second == NULL) return driver_unknown_;
+        return *i->second;
+    }
+
     for (DriverInfo *p : allDrivers())
     {
         if (p->detect(manufacturer, media, version))
         {
+            picked_drivers_[key] = p;
             return *p;
         }
     }
 
+    picked_drivers_[key] = NULL;
     return driver_unknown_;
 }
 
@@ -2156,6 +2225,36 @@ string MeterInfo::str()
     return r;
 }
 
+// Meters often share the same driver spec (eg "multical21:c1") and the
+// spec is re-parsed for every meter at startup and again on config
+// reloads. Remember the outcome per spec so only the first meter pays
+// for the parse. All config parsing runs on the main thread.
+struct ParsedDriverSpec
+{
+    bool ok;
+    DriverName driver_name;
+    string extras;
+    string bus;
+    int bps;
+    LinkModeSet link_modes;
+};
+
+static map<string,ParsedDriverSpec> parsed_driver_specs_;
+
+static void rememberDriverSpec(const string &d, bool ok, MeterInfo *mi)
+{
+    // The number of distinct specs is bounded by the config, but cap
+    // the memo anyway in case something generates specs.
+    if (parsed_driver_specs_.size() >= 4096) return;
+    ParsedDriverSpec &ps = parsed_driver_specs_[d];
+    ps.ok = ok;
+    ps.driver_name = mi->driver_name;
+    ps.extras = mi->extras;
+    ps.bus = mi->bus;
+    ps.bps = mi->bps;
+    ps.link_modes = mi->link_modes;
+}
+
 bool MeterInfo::parse(string n, string d, string aes, string k)
 {
     clear();
@@ -2163,6 +2262,19 @@ bool MeterInfo::parse(string n, string d, string aes, string k)
     name = n;
     address_expressions = splitAddressExpressions(aes);
     key = k;
+
+    auto memo = parsed_driver_specs_.find(d);
+    if (memo != parsed_driver_specs_.end())
+    {
+        const ParsedDriverSpec &ps = memo->second;
+        driver_name = ps.driver_name;
+        extras = ps.extras;
+        bus = ps.bus;
+        bps = ps.bps;
+        link_modes = ps.link_modes;
+        return ps.ok;
+    }
+
     bool driverextras_checked = false;
     bool bus_checked = false;
     bool bps_checked = false;
@@ -2207,10 +2319,13 @@ bool MeterInfo::parse(string n, string d, string aes, string k)
         else
         {
             // Unknown part....
+            rememberDriverSpec(d, false, this);
             return false;
         }
     }
 
+    rememberDriverSpec(d, true, this);
+
     if (!link_modes_checked)
     {
         // No explicit link mode set, set to the default link modes
@@ -168,6 +168,7 @@ private:
     MeterType type_; // Water, Electricity etc.
     function<shared_ptr<Meter>(MeterInfo&,DriverInfo&di)> constructor_; // Invoke this to create an instance of the driver.
     vector<DriverDetect> detect_;
+    uint64_t media_mask_[4] {}; // Bit per media type in detect_, for an O(1) isValidMedia.
     vector<string> default_fields_;
     int force_mfct_index_ = -1; // Used for meters not declaring mfct specific data using the dif 0f.
     bool has_process_content_ = false; // Mark this driver as having mfct specific decoding.
@@ -184,7 +185,11 @@ public:
     void addLinkMode(LinkMode lm) { linkmodes_.addLinkMode(lm); }
     void forceMfctIndex(int i) { force_mfct_index_ = i; }
     void setConstructor(function<shared_ptr<Meter>(MeterInfo&,DriverInfo&)> c) { constructor_ = c; }
-    void addDetection(uint16_t mfct, uchar type, uchar ver) { detect_.push_back({ mfct, type, ver }); }
+    void addDetection(uint16_t mfct, uchar type, uchar ver)
+    {
+        detect_.push_back({ mfct, type, ver });
+        media_mask_[type>>6] |= ((uint64_t)1) << (type&63);
+    }
     void usesProcessContent() { has_process_content_ = true; }
     void setDynamic(const string &file_name, XMQDoc *driver) { dynamic_file_name_ = file_name; dynamic_driver_ = driver; }
     XMQDoc *getDynamicDriver() { return dynamic_driver_; }
@@ -425,15 +430,23 @@ struct Meter
                             vector<string> *envs,
                             vector<string> *more_json,
                             vector<string> *selected_fields,
-                            bool pretty_print_json) = 0;
+                            bool pretty_print_json,
+                            bool skip_formatting = false) = 0;
 
     // The handleTelegram expects an input_frame where the DLL crcs have been removed.
     // Returns true of this meter handled this telegram!
     // Sets id_match to true, if there was an id match, even though the telegram could not be properly handled.
-    virtual bool handleTelegram(AboutTelegram &about, vector<uchar> input_frame,
+    // If the caller has already parsed the header of input_frame, pass it as parsed_header
+    // to avoid parsing it again for every meter.
+    virtual bool handleTelegram(AboutTelegram &about, const vector<uchar> &input_frame,
                                 bool simulated, std::vector<Address> *addresses,
-                                bool *id_match, Telegram *out_t = NULL) = 0;
+                                bool *id_match, Telegram *out_t = NULL,
+                                Telegram *parsed_header = NULL) = 0;
     virtual MeterKeys *meterKeys() = 0;
+    // Re-arm a pooled meter for a new telegram. Clears accumulated values
+    // and re-applies the parts of MeterInfo that vary between telegrams,
+    // instead of constructing a new meter from scratch.
+    virtual void reset(MeterInfo &mi) = 0;
 
     virtual void addExtraCalculatedField(std::string ecf) = 0;
     virtual void addShellMeterAdded(std::string cmdline) = 0;
@@ -454,19 +467,19 @@ struct MeterManager
 {
     virtual void addMeterTemplate(MeterInfo &mi) = 0;
     virtual void addMeter(shared_ptr<Meter> meter) = 0;
-    virtual void triggerMeterAdded(shared_ptr<Meter> meter) = 0;
+    virtual void triggerMeterAdded(Meter *meter) = 0;
     virtual Meter*lastAddedMeter() = 0;
     virtual void removeAllMeters() = 0;
     virtual void forEachMeter(std::function<void(Meter*)> cb) = 0;
-    virtual bool handleTelegram(AboutTelegram &about, vector<uchar> data, bool simulated) = 0;
+    virtual bool handleTelegram(AboutTelegram &about, const vector<uchar> &data, bool simulated) = 0;
     virtual bool hasAllMetersReceivedATelegram() = 0;
     virtual bool hasMeters() = 0;
-    virtual void onTelegram(function<bool(AboutTelegram&,vector<uchar>)> cb) = 0;
-    virtual void whenMeterAdded(std::function<void(shared_ptr<Meter>)> cb) = 0;
+    virtual void onTelegram(function<bool(AboutTelegram&,const vector<uchar>&)> cb) = 0;
+    virtual void whenMeterAdded(std::function<void(Meter*)> cb) = 0;
     virtual void whenMeterUpdated(std::function<void(Telegram*t,Meter*)> cb) = 0;
     virtual void pollMeters(shared_ptr<BusManager> bus) = 0;
     virtual void analyzeEnabled(bool b, OutputFormat f, string force_driver, string key, bool verbose, int profile) = 0;
-    virtual void analyzeTelegram(AboutTelegram &about, vector<uchar> &input_frame, bool simulated) = 0;
+    virtual void analyzeTelegram(AboutTelegram &about, const vector<uchar> &input_frame, bool simulated) = 0;
 
     virtual ~MeterManager() = default;
 };
@@ -84,6 +84,7 @@ struct MeterCommonImplementation : public virtual Meter
 
     static bool isTelegramForMeter(Telegram *t, Meter *meter, MeterInfo *mi);
     MeterKeys *meterKeys();
+    void reset(MeterInfo &mi);
 
     MeterCommonImplementation(MeterInfo &mi, DriverInfo &di);
 
@@ -162,9 +163,10 @@ protected:
     // The default implementation of poll does nothing.
     // Override for mbus meters that need to be queried and likewise for C2/T2 wmbus-meters.
     void poll(shared_ptr<BusManager> bus);
-    bool handleTelegram(AboutTelegram &about, vector<uchar> frame,
+    bool handleTelegram(AboutTelegram &about, const vector<uchar> &frame,
                         bool simulated, std::vector<Address> *addresses,
-                        bool *id_match, Telegram *out_analyzed = NULL);
+                        bool *id_match, Telegram *out_analyzed = NULL,
+                        Telegram *parsed_header = NULL);
     void createMeterEnv(string id,
                         vector<string> *envs,
                         vector<string> *more_json); // Add this json "key"="value" strings.
@@ -175,7 +177,8 @@ protected:
                     vector<string> *envs,
                     vector<string> *more_json, // Add this json "key"="value" strings.
                     vector<string> *selected_fields, // Only print these fields.
-                    bool pretty_print); // Insert newlines and indentation.
+                    bool pretty_print, // Insert newlines and indentation.
+                    bool skip_formatting = false); // Return before building any output, used when profiling decoding.
     // Json fields include all values except timestamp_ut, timestamp_utc, timestamp_lt
     // since Json is assumed to be decoded by a program and the current timestamp which is the
     // same as timestamp_utc, can always be decoded/recoded into local time or a unix timestamp.
@@ -41,12 +41,15 @@ void handleBitToString(Rule& rule, string &out_s, uint64_t bits)
 
     if (rule.mask == AutoMask)
     {
-        mask = 0;
-        for (Map& m : rule.map)
+        if (rule.auto_mask_cache == 0)
         {
-            // Collect all listed bits as the mask.
-            mask |= m.from;
+            for (Map& m : rule.map)
+            {
+                // Collect all listed bits as the mask, once per rule.
+                rule.auto_mask_cache |= m.from;
+            }
         }
+        mask = rule.auto_mask_cache;
     }
 
     bits = bits & mask;
@@ -113,12 +116,15 @@ void handleIndexToString(Rule& rule, string &out_s, uint64_t bits)
 
     if (rule.mask == AutoMask)
     {
-        mask = 0;
-        for (Map& m : rule.map)
+        if (rule.auto_mask_cache == 0)
         {
-            // Collect all listed bits as the mask.
-            mask |= m.from;
+            for (Map& m : rule.map)
+            {
+                // Collect all listed bits as the mask, once per rule.
+                rule.auto_mask_cache |= m.from;
+            }
         }
+        mask = rule.auto_mask_cache;
     }
 
     bits = bits & mask;
@@ -165,12 +171,15 @@ void handleDecimalsToString(Rule& rule, string &out_s, uint64_t bits)
 
     if (rule.mask == AutoMask)
     {
-        mask = 0;
-        for (Map& m : rule.map)
+        if (rule.auto_mask_cache == 0)
         {
-            // Collect all listed bits as the mask.
-            mask |= m.from;
+            for (Map& m : rule.map)
+            {
+                // Collect all listed bits as the mask, once per rule.
+                rule.auto_mask_cache |= m.from;
+            }
         }
+        mask = rule.auto_mask_cache;
     }
 
     // Switch to signed number here.
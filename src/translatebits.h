@@ -92,6 +92,7 @@ namespace Translate
         MaskBits mask; // Bits to be used are set as 1.
         DefaultMessage default_message; // If no bits are set print this, typically "OK" or "".
         std::vector<Map> map;
+        uint64_t auto_mask_cache {}; // Mask collected from map, filled in on first translate when mask is AutoMask.
 
         Rule() {};
         Rule(std::string n, MapType t, TriggerBits tr, MaskBits mb, std::string dm, std::vector<Map> m)
@@ -453,10 +453,17 @@ LIST_OF_QUANTITIES
 
 Unit toUnit(string s)
 {
-#define X(cname,lcname,hrname,quantity,explanation) if (s == #cname || s == #lcname) return Unit::cname;
+    // Both the enum name and the lowercase name resolve to the unit.
+    // Built once, so a lookup is a handful of string compares instead of
+    // running the whole compare chain.
+    static const map<string,Unit> lookup = {
+#define X(cname,lcname,hrname,quantity,explanation) { #cname, Unit::cname }, { #lcname, Unit::cname },
 LIST_OF_UNITS
 #undef X
+    };
 
+    auto i = lookup.find(s);
+    if (i != lookup.end()) return i->second;
     return Unit::Unknown;
 }
 
@@ -585,7 +592,7 @@ LIST_OF_SI_CONVERSIONS
     return Unit::Unknown;
 }
 
-string super(uchar c)
+const char *super(uchar c)
 {
     switch (c)
     {
@@ -609,6 +616,7 @@ string super(uchar c)
 string to_superscript(int8_t n)
 {
     string out;
+    out.reserve(16);
 
     char buf[5];
     sprintf(buf, "%d", n);
@@ -625,6 +633,7 @@ string to_superscript(int8_t n)
 string to_superscript(string &s)
 {
     string out;
+    out.reserve(s.length()*3);
 
     size_t i = 0;
     size_t len = s.length();
@@ -685,15 +694,16 @@ string SIUnit::info() const
 
 int8_t SIExp::safe_add(int8_t a, int8_t b)
 {
-    int sum = a+b;
-    if (sum > 127) invalid_ = true;
+    int8_t sum;
+    // The builtin flags wrap around in both directions with a single add.
+    if (__builtin_add_overflow(a, b, &sum)) invalid_ = true;
     return sum;
 }
 
 int8_t SIExp::safe_sub(int8_t a, int8_t b)
 {
-    int diff = a-b;
-    if (diff  < -128) invalid_ = true;
+    int8_t diff;
+    if (__builtin_sub_overflow(a, b, &diff)) invalid_ = true;
     return diff;
 }
 
@@ -711,19 +721,9 @@ bool SIExp::operator!=(const SIExp &e) const
 
 bool SIExp::operator==(const SIExp &e) const
 {
-    return
-        s_ == e.s_ &&
-        m_ == e.m_ &&
-        kg_ == e.kg_ &&
-        a_ == e.a_ &&
-        mol_ == e.mol_ &&
-        cd_ == e.cd_ &&
-        k_ == e.k_ &&
-        c_ == e.c_ &&
-        f_ == e.f_ &&
-        month_ == e.month_ &&
-        year_ == e.year_ &&
-        unix_timestamp_ == e.unix_timestamp_;
+    // The twelve exponents are contiguous int8_t members from s_ to
+    // unix_timestamp_, so they compare in two word sized chunks.
+    return memcmp(&s_, &e.s_, 12) == 0;
 }
 
 SIExp SIExp::mul(const SIExp &e) const
@@ -790,6 +790,7 @@ SIExp SIExp::sqrt() const
 string SIExp::str() const
 {
     string r;
+    r.reserve(32);
 
     DO_UNIT_SIEXP(mol_, mol);
     DO_UNIT_SIEXP(cd_, cd);
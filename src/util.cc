@@ -132,15 +132,24 @@ void restoreSignalHandlers()
     sigaction(SIGUSR2, &old_usr2, NULL);
 }
 
+// Hex digit values for every byte value, -1 for non hex. One table load
+// replaces the three range checks per character, and hex decoding runs
+// over every ingested telegram.
+static struct HexDigitTable
+{
+    signed char v[256];
+    HexDigitTable()
+    {
+        for (int i = 0; i < 256; ++i) v[i] = -1;
+        for (int i = '0'; i <= '9'; ++i) v[i] = i - '0';
+        for (int i = 'A'; i <= 'F'; ++i) v[i] = i - 'A' + 10;
+        for (int i = 'a'; i <= 'f'; ++i) v[i] = i - 'a' + 10;
+    }
+} hex_digit_table_;
+
 int char2int(char input)
 {
-    if(input >= '0' && input <= '9')
-        return input - '0';
-    if(input >= 'A' && input <= 'F')
-        return input - 'A' + 10;
-    if(input >= 'a' && input <= 'f')
-        return input - 'a' + 10;
-    return -1;
+    return hex_digit_table_.v[(uchar)input];
 }
 
 bool isHexChar(uchar c)
@@ -174,16 +183,29 @@ bool isHexString(const char* txt, bool *invalid, bool strict)
 
     const char *i = txt;
     int n = 0;
-    for (;;)
-    {
-        char c = *i++;
-        if (!strict && c == '#') continue; // Ignore hashes if not strict
-        if (!strict && c == ' ') continue; // Ignore hashes if not strict
-        if (!strict && c == '|') continue; // Ignore hashes if not strict
-        if (!strict && c == '_') continue; // Ignore underlines if not strict
-        if (c == 0) break;
-        n++;
-        if (char2int(c) == -1) return false;
+    if (strict)
+    {
+        for (;;)
+        {
+            char c = *i++;
+            if (c == 0) break;
+            n++;
+            if (char2int(c) == -1) return false;
+        }
+    }
+    else
+    {
+        for (;;)
+        {
+            char c = *i++;
+            if (c == '#') continue; // Ignore hashes if not strict
+            if (c == ' ') continue; // Ignore spaces if not strict
+            if (c == '|') continue; // Ignore pipes if not strict
+            if (c == '_') continue; // Ignore underlines if not strict
+            if (c == 0) break;
+            n++;
+            if (char2int(c) == -1) return false;
+        }
     }
     // An empty string is not an hex string.
     if (n == 0) return false;
@@ -215,17 +237,26 @@ bool isHexStringStrict(const string &txt, bool *invalid)
 bool hex2bin(const char* src, vector<uchar> *target)
 {
     if (!src) return false;
+    // The decode at most halves the length, reserve up front so the loop
+    // does not have to regrow the vector.
+    target->reserve(target->size() + strlen(src)/2);
     while(*src && src[1]) {
+        int hi = char2int(*src);
+        int lo = char2int(src[1]);
+        // Invalid digits are -1, one sign test covers both. Decoding a plain
+        // hex pair is the common case, separators are the exception, so the
+        // separator tests only run when the pair did not decode.
+        if ((hi|lo) >= 0) {
+            target->push_back((hi<<4) | lo);
+            src += 2;
+            continue;
+        }
         if (*src == ' ' || *src == '#' || *src == '|' || *src == '_') {
             // Ignore space and hashes and pipes and underlines.
             src++;
-        } else {
-            int hi = char2int(*src);
-            int lo = char2int(src[1]);
-            if (hi<0 || lo<0) return false;
-            target->push_back(hi*16 + lo);
-            src += 2;
+            continue;
         }
+        return false;
     }
     return true;
 }
@@ -238,12 +269,13 @@ bool hex2bin(const string &src, vector<uchar> *target)
 bool hex2bin(vector<uchar> &src, vector<uchar> *target)
 {
     if (src.size() % 2 == 1) return false;
+    target->reserve(target->size() + src.size()/2);
     for (size_t i=0; i<src.size(); i+=2) {
         if (src[i] != ' ') {
             int hi = char2int(src[i]);
             int lo = char2int(src[i+1]);
-            if (hi<0 || lo<0) return false;
-            target->push_back(hi*16 + lo);
+            if ((hi|lo) < 0) return false;
+            target->push_back((hi<<4) | lo);
         }
     }
     return true;
@@ -253,6 +285,7 @@ char const hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A','B'
 
 string bin2hex(const vector<uchar> &target) {
     string str;
+    str.reserve(target.size()*2);
     for (size_t i = 0; i < target.size(); ++i) {
         const char ch = target[i];
         str.append(&hex[(ch  & 0xF0) >> 4], 1);
@@ -263,6 +296,7 @@ string bin2hex(const vector<uchar> &target) {
 
 string bin2hex(vector<uchar>::iterator data, vector<uchar>::iterator end, int len) {
     string str;
+    if (len > 0) str.reserve(len*2);
     while (data != end && len-- > 0) {
         const char ch = *data;
         data++;
@@ -274,6 +308,7 @@ string bin2hex(vector<uchar>::iterator data, vector<uchar>::iterator end, int le
 
 string bin2hex(vector<uchar> &data, int offset, int len) {
     string str;
+    if (len > 0) str.reserve(len*2);
     vector<uchar>::iterator i = data.begin();
     i += offset;
     while (i != data.end() && len-- > 0) {
@@ -904,15 +939,43 @@ uint16_t crc16_EN13757_per_byte(uint16_t crc, uchar b)
     return crc;
 }
 
+// Sliced tables for the EN 13757 crc, built once from the bit serial
+// routine above. t0 is the plain byte-wise table, t1 is the crc of a byte
+// followed by a zero byte, so two message bytes fold with two independent
+// lookups per iteration. The crc runs over every received frame, but the
+// crc:ed blocks are short (16 bytes), deeper slicing does not pay here.
+static struct CRC16EN13757Table
+{
+    uint16_t t0[256];
+    uint16_t t1[256];
+    CRC16EN13757Table()
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            t0[b] = crc16_EN13757_per_byte(0, (uchar)b);
+        }
+        for (int b = 0; b < 256; ++b)
+        {
+            t1[b] = (t0[b] << 8) ^ t0[(t0[b] >> 8) & 0xff];
+        }
+    }
+} crc16_en13757_table_;
+
 uint16_t crc16_EN13757(uchar *data, size_t len)
 {
     uint16_t crc = 0x0000;
 
     assert(len == 0 || data != NULL);
 
-    for (size_t i=0; i<len; ++i)
+    size_t i = 0;
+    for (; i+1 < len; i += 2)
     {
-        crc = crc16_EN13757_per_byte(crc, data[i]);
+        crc = crc16_en13757_table_.t1[((crc >> 8) ^ data[i]) & 0xff]
+            ^ crc16_en13757_table_.t0[(crc ^ data[i+1]) & 0xff];
+    }
+    if (i < len)
+    {
+        crc = (crc << 8) ^ crc16_en13757_table_.t0[((crc >> 8) ^ data[i]) & 0xff];
     }
 
     return (~crc);
@@ -1161,13 +1224,15 @@ string strdatetimesec(double v)
 bool is_leap_year(int year)
 {
     year += 1900;
-    if (year % 4 != 0) return false;
-    if (year % 400 == 0) return true;
-    if (year % 100 == 0) return false;
-    return true;
+    // Branchless: divisible by 4, and not by 100 unless also by 400.
+    return ((year & 3) == 0) & ((year % 100 != 0) | (year % 400 == 0));
 }
 
-int days_in_months[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+// Both rows, indexed by the leap year flag.
+int days_in_months[2][12] = {
+    {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31},
+    {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}
+};
 
 int get_days_in_month(int year, int month)
 {
@@ -1176,15 +1241,7 @@ int get_days_in_month(int year, int month)
         month = 0;
     }
 
-    int days = days_in_months[month];
-
-    if (month == 1 && is_leap_year(year))
-    {
-        // Handle february in a leap year.
-        days += 1;
-    }
-
-    return days;
+    return days_in_months[is_leap_year(year)][month];
 }
 
 double addMonths(double t, int months)
@@ -1200,16 +1257,11 @@ void addMonths(struct tm *date, int months)
 {
     bool is_last_day_in_month = date->tm_mday == get_days_in_month(date->tm_year, date->tm_mon);
 
-    int year = date->tm_year + months / 12;
-    int month = date->tm_mon + months % 12;
-
-    while (month > 11)
-    {
-        year += 1;
-        month -= 12;
-    }
-
-    while (month < 0)
+    // Normalize arithmetically instead of looping month by month.
+    int total = date->tm_year*12 + date->tm_mon + months;
+    int year = total / 12;
+    int month = total % 12;
+    if (month < 0)
     {
         year -= 1;
         month += 12;
@@ -1436,6 +1488,8 @@ struct TimePeriod
     int day_in_week_to {}; // 0 = mon 6 = sun
     int hour_from {}; // Greater than or equal.
     int hour_to {}; // Less than or equal.
+    uint32_t days {}; // Bit per covered weekday, bit 0 = mon.
+    uint32_t hours {}; // Bit per covered hour since midnight.
 };
 
 bool is_inside(struct tm *nowt, TimePeriod *tp)
@@ -1446,11 +1500,7 @@ bool is_inside(struct tm *nowt, TimePeriod *tp)
 
     // Test is inclusive. mon-sun(00-23) will cover whole week all hours.
     // mon-tue(00-00) will cover mon and tue one hour after midnight.
-    if (day >= tp->day_in_week_from && day <= tp->day_in_week_to && hour >= tp->hour_from && hour <= tp->hour_to)
-    {
-        return true;
-    }
-    return false;
+    return (tp->days >> day) & (tp->hours >> hour) & 1;
 }
 
 bool extract_times(const char *p, TimePeriod *tp)
@@ -1527,6 +1577,11 @@ bool extract_single_period(char *tok, TimePeriod *tp)
     ok = extract_days(tok, tp);
     if (!ok) return false;
 
+    // Compile the period to weekday/hour bitmaps once, so that the
+    // membership test in is_inside is just two shifts and an and.
+    for (int d = tp->day_in_week_from; d <= tp->day_in_week_to; ++d) tp->days |= 1 << d;
+    for (int h = tp->hour_from; h <= tp->hour_to; ++h) tp->hours |= 1 << h;
+
     return true;
 }
 
@@ -1960,24 +2015,27 @@ string reverseBinaryAsciiSafeToString(const string& v)
 
 void addSlipFraming(vector<uchar>& from, vector<uchar> &to)
 {
+    // Worst case every byte needs escaping, plus the two frame ends.
+    to.reserve(to.size() + from.size()*2 + 2);
     to.push_back(SLIP_END);
-    for (uchar c : from)
+
+    // Escapes are rare, so copy the unescaped runs in bulk instead of
+    // pushing byte by byte.
+    const uchar *p = from.data();
+    const uchar *end = p + from.size();
+    const uchar *run = p;
+    for (; p < end; ++p)
     {
-        if (c == SLIP_END)
+        uchar c = *p;
+        if (c == SLIP_END || c == SLIP_ESC)
         {
+            to.insert(to.end(), run, p);
             to.push_back(SLIP_ESC);
-            to.push_back(SLIP_ESC_END);
-        }
-        else if (c == SLIP_ESC)
-        {
-            to.push_back(SLIP_ESC);
-            to.push_back(SLIP_ESC_ESC);
-        }
-        else
-        {
-            to.push_back(c);
+            to.push_back(c == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC);
+            run = p+1;
         }
     }
+    to.insert(to.end(), run, end);
     to.push_back(SLIP_END);
 }
 
@@ -1987,11 +2045,22 @@ void removeSlipFraming(vector<uchar>& from, size_t *frame_length, vector<uchar>
     to.clear();
     to.reserve(from.size());
     bool esc = false;
-    size_t i;
+    size_t i = 0;
     bool found_end = false;
 
     for (i = 0; i < from.size(); ++i)
     {
+        if (!esc)
+        {
+            // Bulk-copy the run of ordinary bytes up to the next frame
+            // end or escape, which for a well formed frame is nearly
+            // all of it.
+            size_t run = i;
+            while (run < from.size() && from[run] != SLIP_END && from[run] != SLIP_ESC) run++;
+            to.insert(to.end(), from.begin()+i, from.begin()+run);
+            i = run;
+            if (i == from.size()) break;
+        }
         uchar c = from[i];
         if (c == SLIP_END)
         {
@@ -2033,32 +2102,40 @@ void removeSlipFraming(vector<uchar>& from, size_t *frame_length, vector<uchar>
 // Check if hex string is likely to be ascii
 bool isLikelyAscii(const string& v)
 {
-    vector<uchar> val;
-    bool ok = hex2bin(v, &val);
-
     // For example 64 bits:
     // 0000 0000 4142 4344
     // is probably the string DCBA
 
-    if (!ok) return false;
-
-    size_t i = 0;
-    for (; i < val.size(); ++i)
+    // Decode and classify pairwise in one pass, without materializing
+    // the binary bytes in a vector. Same separator handling as hex2bin.
+    const char *src = v.c_str();
+    bool seen_nonzero = false;
+    while (*src && src[1])
     {
-        if (val[i] != 0) break;
+        if (*src == ' ' || *src == '#' || *src == '|' || *src == '_')
+        {
+            src++;
+            continue;
+        }
+        int hi = char2int(src[0]);
+        int lo = char2int(src[1]);
+        if ((hi|lo) < 0) return false; // Not hex.
+        uchar c = (hi<<4) | lo;
+        src += 2;
+        if (!seen_nonzero)
+        {
+            if (c == 0) continue; // Leading zero padding.
+            seen_nonzero = true;
+        }
+        if (c < 20 || c > 126) return false;
     }
 
-    if (i == val.size())
+    if (!seen_nonzero)
     {
-        // Value is all zeroes, this is probably a number.
+        // Value is all zeroes (or empty), this is probably a number.
         return false;
     }
 
-    for (; i < val.size(); ++i)
-    {
-        if (val[i] < 20 || val[i] > 126) return false;
-    }
-
     return true;
 }
 
@@ -2111,36 +2188,33 @@ string joinStatusEmptyStrings(const string &aa, const string &bb)
 
 string sortStatusString(const string &a)
 {
-    set<string> flags;
-    string curr;
-
-    for (size_t i=0; i<a.length(); ++i)
+    // Tokenize into (offset,length) pairs pointing into a, then sort
+    // and deduplicate those, instead of building a set of strings with
+    // one allocation per flag.
+    vector<pair<size_t,size_t>> tokens;
+    size_t i = 0;
+    while (i < a.length())
     {
-        uchar c = a[i];
-        if (c == ' ')
-        {
-            if (curr.length() > 0)
-            {
-                flags.insert(curr);
-                curr = "";
-            }
-        }
-        else
-        {
-            curr += c;
-        }
+        while (i < a.length() && a[i] == ' ') i++;
+        size_t start = i;
+        while (i < a.length() && a[i] != ' ') i++;
+        if (i > start) tokens.push_back(make_pair(start, i-start));
     }
 
-    if (curr.length() > 0)
-    {
-        flags.insert(curr);
-        curr = "";
-    }
+    sort(tokens.begin(), tokens.end(),
+         [&a](const pair<size_t,size_t> &x, const pair<size_t,size_t> &y) {
+             return a.compare(x.first, x.second, a, y.first, y.second) < 0;
+         });
 
     string result;
-    for (auto &s : flags)
-    {
-        result += s+" ";
+    result.reserve(a.length());
+    for (size_t t = 0; t < tokens.size(); ++t)
+    {
+        // Skip duplicate flags, the old set did the same.
+        if (t > 0 && a.compare(tokens[t-1].first, tokens[t-1].second,
+                               a, tokens[t].first, tokens[t].second) == 0) continue;
+        result.append(a, tokens[t].first, tokens[t].second);
+        result += ' ';
     }
 
     while (result.size() > 0 && result.back() == ' ') result.pop_back();
@@ -1936,7 +1936,7 @@ void Telegram::preProcess()
     }
 }
 
-bool Telegram::parse(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parse(const vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     switch (about.type)
     {
@@ -1948,7 +1948,7 @@ bool Telegram::parse(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
     return false;
 }
 
-bool Telegram::parseHeader(vector<uchar> &input_frame)
+bool Telegram::parseHeader(const vector<uchar> &input_frame)
 {
     switch (about.type)
     {
@@ -1960,7 +1960,7 @@ bool Telegram::parseHeader(vector<uchar> &input_frame)
     return false;
 }
 
-bool Telegram::parseWMBUSHeader(vector<uchar> &input_frame)
+bool Telegram::parseWMBUSHeader(const vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::WMBUS);
 
@@ -2000,7 +2000,7 @@ bool Telegram::parseWMBUSHeader(vector<uchar> &input_frame)
     return true;
 }
 
-bool Telegram::parseWMBUS(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseWMBUS(const vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::WMBUS);
 
@@ -2077,7 +2077,7 @@ bool Telegram::parseWMBUS(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
     return true;
 }
 
-bool Telegram::parseMBUSHeader(vector<uchar> &input_frame)
+bool Telegram::parseMBUSHeader(const vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::MBUS);
 
@@ -2100,7 +2100,7 @@ bool Telegram::parseMBUSHeader(vector<uchar> &input_frame)
     return true;
 }
 
-bool Telegram::parseMBUS(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseMBUS(const vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::MBUS);
 
@@ -2128,14 +2128,14 @@ bool Telegram::parseMBUS(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
     return true;
 }
 
-bool Telegram::parseHANHeader(vector<uchar> &input_frame)
+bool Telegram::parseHANHeader(const vector<uchar> &input_frame)
 {
     assert(about.type == FrameType::HAN);
 
     return false;
 }
 
-bool Telegram::parseHAN(vector<uchar> &input_frame, MeterKeys *mk, bool warn)
+bool Telegram::parseHAN(const vector<uchar> &input_frame, MeterKeys *mk, bool warn)
 {
     assert(about.type == FrameType::HAN);
 
@@ -4112,7 +4112,7 @@ string BusDeviceCommonImplementation::busAlias()
     return bus_alias_;
 }
 
-void BusDeviceCommonImplementation::onTelegram(function<bool(AboutTelegram&,vector<uchar>)> cb)
+void BusDeviceCommonImplementation::onTelegram(function<bool(AboutTelegram&,const vector<uchar>&)> cb)
 {
     telegram_listeners_.push_back(cb);
 }
@@ -4164,7 +4164,7 @@ bool BusDeviceCommonImplementation::handleTelegram(AboutTelegram &about, vector<
         }
     }
 
-    for (auto f : telegram_listeners_)
+    for (auto &f : telegram_listeners_)
     {
         if (f)
         {
@@ -5082,9 +5082,17 @@ LIST_OF_MBUS_DEVICES
 
 BusDeviceType toBusDeviceType(string &t)
 {
-#define X(name,text,tty,rtlsdr,detector) if (t == #text) return DEVICE_ ## name;
+    // Built once from the X macro list; a single map lookup instead of
+    // one string compare per known device type. This runs for every
+    // part of every device spec while probing.
+    static const map<string,BusDeviceType> devices = {
+#define X(name,text,tty,rtlsdr,detector) { #text, DEVICE_ ## name },
 LIST_OF_MBUS_DEVICES
 #undef X
+    };
+
+    auto i = devices.find(t);
+    if (i != devices.end()) return i->second;
     return DEVICE_UNKNOWN;
 }
 
@@ -35,7 +35,7 @@ struct BusDeviceCommonImplementation : public virtual BusDevice
     string hr();
     bool isSerial();
     BusDeviceType type();
-    void onTelegram(function<bool(AboutTelegram&,vector<uchar>)> cb);
+    void onTelegram(function<bool(AboutTelegram&,const vector<uchar>&)> cb);
     bool sendTelegram(LinkMode link_mode, TelegramFormat format, vector<uchar> &content);
     bool handleTelegram(AboutTelegram &about, vector<uchar> frame);
     void checkStatus();
@@ -87,7 +87,7 @@ struct BusDeviceCommonImplementation : public virtual BusDevice
     // Uses a serial tty?
     bool is_serial_ {};
     bool is_working_ {};
-    vector<function<bool(AboutTelegram&,vector<uchar>)>> telegram_listeners_;
+    vector<function<bool(AboutTelegram&,const vector<uchar>&)>> telegram_listeners_;
     BusDeviceType type_ {};
     int protocol_error_count_ {};
     time_t timeout_ {}; // If longer silence than timeout, then reset dongle! It might have hanged!